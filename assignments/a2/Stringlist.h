@@ -38,10 +38,58 @@ using namespace std;
 
 class Stringlist
 {
+    //
+    // The kinds of records on the undo and redo stacks. Each record describes
+    // the *inverse* of the operation that pushed it, i.e. what must be done to
+    // get back to the previous state of the list.
+    //
+    // Applying a record turns it into its own inverse (see invert), so the
+    // same record is moved back and forth between the undo and redo stacks
+    // without copying any strings.
+    //
+    enum class Undo_op : char
+    {
+        REMOVE,  // remove count strings starting at index
+        INSERT,  // insert count saved strings before index
+        SET,     // swap the string at index with value
+        RESTORE, // swap the entire list with saved (size count, capacity saved_cap)
+    };
+
+    //
+    // A node in the undo or redo stack, each of which is a singly-linked list
+    // whose head is the most recent operation.
+    //
+    // A single saved string is stored in value, and more than one are stored
+    // in the saved array. Saved strings are always moved, never copied.
+    //
+    // Each record has an ID, which is bigger than the ID of every record
+    // pushed before it, so the IDs on the undo stack decrease from the top.
+    //
+    struct Undo_node
+    {
+        Undo_op op;
+        long id = 0;
+        int index = 0;
+        int count = 0;
+        int saved_cap = 0;
+        string value;
+        string *saved = nullptr; // owned by this node
+        Undo_node *next = nullptr;
+
+        ~Undo_node()
+        {
+            delete[] saved;
+        }
+    }; // struct Undo_node
+
     int cap;     // capacity
     string *arr; // array of strings
     int sz;      // size
 
+    Undo_node *undo_top; // top of the undo stack; nullptr if empty
+    Undo_node *redo_top; // top of the redo stack; nullptr if empty
+    long last_id;        // ID of the most recently pushed record
+
     //
     // Helper function for throwing out_of_range exceptions.
     //
@@ -72,21 +120,174 @@ class Stringlist
 
     //
     // Helper function for checking capacity; doubles size of the underlying
-    // array if necessary.
+    // array as many times as necessary so that it can hold at least n strings.
+    // At most one new array is allocated, and the strings are moved into it.
     //
-    void check_capacity()
+    void check_capacity(int n)
     {
-        if (sz == cap)
+        if (n <= cap)
+            return;
+
+        if (cap == 0) // a moved-from list has no array
+            cap = 1;
+        while (cap < n)
         {
             cap *= 2;
-            string *temp = new string[cap];
-            for (int i = 0; i < sz; i++)
-            {
-                temp[i] = arr[i];
-            }
-            delete[] arr;
-            arr = temp;
         }
+        string *temp = new string[cap];
+        for (int i = 0; i < sz; i++)
+        {
+            temp[i] = std::move(arr[i]);
+        }
+        delete[] arr;
+        arr = temp;
+    }
+
+    //
+    // Helper function that opens a gap of k empty strings starting at index by
+    // moving everything after it k positions to the right. The capacity is
+    // increased at most once.
+    //
+    void shift_right(int index, int k)
+    {
+        if (k == 0) // avoids moving strings onto themselves
+            return;
+        check_capacity(sz + k);
+        for (int i = sz - 1; i >= index; i--)
+        {
+            arr[i + k] = std::move(arr[i]);
+        }
+        sz += k;
+    }
+
+    //
+    // Helper function that removes the k strings starting at index by moving
+    // everything after them k positions to the left.
+    //
+    void shift_left(int index, int k)
+    {
+        if (k == 0) // avoids moving strings onto themselves
+            return;
+        for (int i = index + k; i < sz; i++)
+        {
+            arr[i - k] = std::move(arr[i]);
+        }
+        sz -= k;
+    }
+
+    //
+    // Helper function that moves the node->count strings starting at
+    // node->index out of the list and into node.
+    //
+    void save_strings(Undo_node *node)
+    {
+        if (node->count == 1)
+        {
+            node->value = std::move(arr[node->index]);
+            return;
+        }
+        node->saved = new string[node->count];
+        for (int i = 0; i < node->count; i++)
+        {
+            node->saved[i] = std::move(arr[node->index + i]);
+        }
+    }
+
+    //
+    // Helper function that moves the strings saved in node back into the list
+    // starting at node->index, which must already have room for them.
+    //
+    void restore_strings(Undo_node *node)
+    {
+        if (node->count == 1)
+        {
+            arr[node->index] = std::move(node->value);
+            return;
+        }
+        for (int i = 0; i < node->count; i++)
+        {
+            arr[node->index + i] = std::move(node->saved[i]);
+        }
+        delete[] node->saved;
+        node->saved = nullptr;
+    }
+
+    //
+    // Helper function that applies the operation stored in node to the list,
+    // and then changes node into the inverse of that operation.
+    //
+    // The capacity of the list is never decreased, so when node came from an
+    // earlier state of this list no re-allocation is needed.
+    //
+    void invert(Undo_node *node)
+    {
+        switch (node->op)
+        {
+        case Undo_op::REMOVE:
+            save_strings(node);
+            shift_left(node->index, node->count);
+            node->op = Undo_op::INSERT;
+            break;
+        case Undo_op::INSERT:
+            shift_right(node->index, node->count);
+            restore_strings(node);
+            node->op = Undo_op::REMOVE;
+            break;
+        case Undo_op::SET:
+            arr[node->index].swap(node->value);
+            break;
+        case Undo_op::RESTORE:
+            std::swap(arr, node->saved);
+            std::swap(cap, node->saved_cap);
+            std::swap(sz, node->count);
+            break;
+        }
+    }
+
+    //
+    // Helper function that deletes every record on the given stack.
+    //
+    static void clear_stack(Undo_node *&top)
+    {
+        while (top != nullptr)
+        {
+            Undo_node *node = top;
+            top = top->next;
+            delete node;
+        }
+    }
+
+    //
+    // Helper function that pushes a new record onto the undo stack, and
+    // returns it so the caller can fill in its details. Since the list is
+    // about to be changed by a new operation, the redo stack is cleared.
+    //
+    Undo_node *push_undo(Undo_op op, int index, int count)
+    {
+        clear_stack(redo_top);
+        Undo_node *node = new Undo_node;
+        node->op = op;
+        node->index = index;
+        node->count = count;
+        node->id = ++last_id;
+        node->next = undo_top;
+        undo_top = node;
+        return node;
+    }
+
+    //
+    // Helper function that pushes a RESTORE record that takes ownership of
+    // the current underlying array, and then replaces it with an empty array
+    // of capacity new_cap. No strings are copied.
+    //
+    void push_restore(int new_cap)
+    {
+        Undo_node *node = push_undo(Undo_op::RESTORE, 0, sz);
+        node->saved = arr;
+        node->saved_cap = cap;
+        cap = new_cap;
+        arr = new string[cap];
+        sz = 0;
     }
 
 public:
@@ -94,27 +295,50 @@ public:
     // Default constructor: makes an empty StringList.
     //
     Stringlist()
-        : cap(10), arr(new string[cap]), sz(0)
+        : cap(10), arr(new string[cap]), sz(0),
+          undo_top(nullptr), redo_top(nullptr), last_id(0)
     {
     }
 
     //
     // Copy constructor: makes a copy of the given StringList.
     //
-    // Does *not* copy the undo stack, or any undo information from other.
+    // Does *not* copy the undo or redo stacks, or any undo information from
+    // other.
     //
     Stringlist(const Stringlist &other)
-        : cap(other.cap), arr(new string[cap]), sz(other.sz)
+        : cap(other.cap), arr(new string[cap]), sz(other.sz),
+          undo_top(nullptr), redo_top(nullptr), last_id(0)
     {
         copy(other.arr);
     }
 
+    //
+    // Move constructor: takes the strings *and* the undo and redo stacks from
+    // other, without copying any strings. other is left as an empty list with
+    // capacity 0 and empty undo and redo stacks.
+    //
+    // Stringlist &&other is an rvalue reference, i.e. a reference to a
+    // temporary list (or one passed through std::move) whose contents can be
+    // taken. noexcept promises that no exceptions are thrown, which lets
+    // containers like vector<Stringlist> move lists instead of copying them
+    // when they grow.
+    //
+    Stringlist(Stringlist &&other) noexcept
+        : cap(0), arr(nullptr), sz(0),
+          undo_top(nullptr), redo_top(nullptr), last_id(0)
+    {
+        swap(other);
+    }
+
     //
     // destructor
     //
     ~Stringlist()
     {
         delete[] arr;
+        clear_stack(undo_top);
+        clear_stack(redo_top);
     }
 
     //
@@ -141,15 +365,49 @@ public:
     {
         if (this != &other)
         {
-            delete[] arr;
-            cap = other.capacity();
-            arr = new string[cap];
+            // the old array is kept on the undo stack instead of being deleted
+            push_restore(other.capacity());
             sz = other.size();
             copy(other.arr);
         }
         return *this;
     }
 
+    //
+    // Move assignment operator: takes the strings *and* the undo and redo
+    // stacks from other, without copying any strings. The previous contents
+    // and stacks of this list are deleted, and so this is *not* undoable.
+    // other is left as an empty list with capacity 0 and empty undo and redo
+    // stacks.
+    //
+    // Moving a list to itself does nothing.
+    //
+    Stringlist &operator=(Stringlist &&other) noexcept
+    {
+        if (this != &other)
+        {
+            // temp takes other's contents, and then this list swaps its old
+            // contents into temp, which deletes them when it goes out of scope
+            Stringlist temp(std::move(other));
+            swap(temp);
+        }
+        return *this;
+    }
+
+    //
+    // Swaps the contents and undo/redo stacks of this list and other in O(1)
+    // time. No strings are copied. Not undoable.
+    //
+    void swap(Stringlist &other) noexcept
+    {
+        std::swap(cap, other.cap);
+        std::swap(arr, other.arr);
+        std::swap(sz, other.sz);
+        std::swap(undo_top, other.undo_top);
+        std::swap(redo_top, other.redo_top);
+        std::swap(last_id, other.last_id);
+    }
+
     //
     // Returns the number of strings in the list.
     //
@@ -199,18 +457,69 @@ public:
     }
 
     //
-    // Returns a string representation of the list.
+    // Returns the number of characters in the string representation of the
+    // list, i.e. to_string().size(), without building the string.
     //
-    string to_string() const
+    size_t to_string_length() const
+    {
+        // 2 for the {}-brackets, 2 for each pair of ""-marks, and 2 for each
+        // ", " separator
+        size_t len = 2;
+        for (int i = 0; i < sz; i++)
+        {
+            len += arr[i].size() + 2;
+        }
+        if (sz > 1)
+            len += 2 * (sz - 1);
+        return len;
+    }
+
+    //
+    // Appends the string representation of the list to the end of out. The
+    // exact length is calculated first so that out is re-allocated at most
+    // once.
+    //
+    void append_to(string &out) const
     {
-        string result = "{";
-        for (int i = 0; i < size(); i++)
+        out.reserve(out.size() + to_string_length());
+        out += '{';
+        for (int i = 0; i < sz; i++)
+        {
+            if (i > 0)
+                out += ", ";
+            out += '"';
+            out += arr[i];
+            out += '"';
+        }
+        out += '}';
+    }
+
+    //
+    // Writes the string representation of the list directly to os, without
+    // building any intermediate strings.
+    //
+    void write_to(ostream &os) const
+    {
+        os.put('{');
+        for (int i = 0; i < sz; i++)
         {
             if (i > 0)
-                result += ", ";
-            result += "\"" + get(i) + "\"";
+                os.write(", ", 2);
+            os.put('"');
+            os.write(arr[i].data(), arr[i].size());
+            os.put('"');
         }
-        return result + "}";
+        os.put('}');
+    }
+
+    //
+    // Returns a string representation of the list.
+    //
+    string to_string() const
+    {
+        string result;
+        append_to(result);
+        return result;
     }
 
     //
@@ -221,7 +530,8 @@ public:
     void set(int index, string value)
     {
         check_bounds("set", index);
-        arr[index] = value;
+        push_undo(Undo_op::SET, index, 1)->value = std::move(arr[index]);
+        arr[index] = std::move(value);
     }
 
     //
@@ -234,14 +544,9 @@ public:
     {
         if (index < 0 || index > sz) // allows insert at end, i == sz
             bounds_error("insert_before");
-        check_capacity();
-
-        for (int i = sz; i > index; i--)
-        {
-            arr[i] = arr[i - 1];
-        }
+        push_undo(Undo_op::REMOVE, index, 1);
+        shift_right(index, 1);
         arr[index] = s;
-        sz++;
     }
 
     //
@@ -274,11 +579,8 @@ public:
     void remove_at(int index)
     {
         check_bounds("remove_at", index);
-        for (int i = index; i < sz - 1; i++)
-        {
-            arr[i] = arr[i + 1];
-        }
-        sz--;
+        save_strings(push_undo(Undo_op::INSERT, index, 1));
+        shift_left(index, 1);
     }
 
     //
@@ -288,9 +590,74 @@ public:
     //
     void remove_all()
     {
-        while (sz > 0)
+        push_restore(cap);
+    }
+
+    //
+    // Inserts the strings in the range [first, last) before index, in order;
+    // if necessary, the capacity of the underlying array is increased (at most
+    // once). The existing strings are shifted only once, so inserting k
+    // strings is O(n + k).
+    //
+    // first and last must not refer to strings in this list, except as done
+    // by append.
+    //
+    // undoable: the entire insertion is undone by one call to undo()
+    //
+    template <typename Iter>
+    void insert_range(int index, Iter first, Iter last)
+    {
+        if (index < 0 || index > sz) // allows insert at end, i == sz
+            bounds_error("insert_range");
+
+        int k = 0;
+        for (Iter it = first; it != last; ++it)
+        {
+            k++;
+        }
+
+        push_undo(Undo_op::REMOVE, index, k);
+        shift_right(index, k);
+        for (int i = index; first != last; ++first, i++)
+        {
+            arr[i] = *first;
+        }
+    }
+
+    //
+    // Removes the strings at indices i, i + 1, ..., j - 1; doesn't change the
+    // capacity. Requires 0 <= i <= j <= size().
+    //
+    // undoable: the entire removal is undone by one call to undo()
+    //
+    void remove_range(int i, int j)
+    {
+        if (i < 0 || j < i || j > sz)
+            bounds_error("remove_range");
+
+        save_strings(push_undo(Undo_op::INSERT, i, j - i));
+        shift_left(i, j - i);
+    }
+
+    //
+    // Appends all the strings in other to the end of this list. other can be
+    // this list itself, e.g. lst.append(lst) doubles lst.
+    //
+    // undoable: the entire append is undone by one call to undo()
+    //
+    void append(const Stringlist &other)
+    {
+        int start = sz;
+        int other_sz = other.sz;
+        push_undo(Undo_op::REMOVE, start, other_sz);
+        shift_right(start, other_sz);
+
+        // Appending never moves the existing strings, so if other is this
+        // list its strings are still at the front of arr after shift_right
+        // (which might have re-allocated arr).
+        for (int i = 0; i < other_sz; i++)
         {
-            remove_at(sz - 1);
+            arr[start + i] = other.arr[i];
         }
     }
 
@@ -317,8 +684,72 @@ public:
     //
     bool undo()
     {
-        cout << "Stringlist::undo: not yet implemented\n";
-        return false;
+        if (undo_top == nullptr)
+            return false;
+
+        Undo_node *node = undo_top;
+        undo_top = undo_top->next;
+        invert(node);
+        node->next = redo_top;
+        redo_top = node;
+        return true;
+    }
+
+    //
+    // Re-does the last operation that was undone. Returns true if a change was
+    // re-done.
+    //
+    // If there is nothing to redo, does nothing and returns false. Any
+    // undoable operation other than undo clears all the redo information.
+    //
+    bool redo()
+    {
+        if (redo_top == nullptr)
+            return false;
+
+        Undo_node *node = redo_top;
+        redo_top = redo_top->next;
+        invert(node);
+        node->next = undo_top;
+        undo_top = node;
+        return true;
+    }
+
+    //
+    // Returns a checkpoint for the current state of the list that can later be
+    // passed to undo_to. The checkpoint is the ID of the record on top of the
+    // undo stack, or 0 if there is nothing to undo.
+    //
+    long mark() const { return undo_top == nullptr ? 0 : undo_top->id; }
+
+    //
+    // Undoes operations until the list is back in the state it was in when
+    // checkpoint m was made by mark(). Returns true if any change was undone.
+    // Each undone operation can be re-done with redo().
+    //
+    // If m's record is no longer on the undo stack, i.e. the list has been
+    // undone to before m (and maybe changed since, which discards m's record
+    // with the rest of the redo stack), does nothing and returns false.
+    //
+    // No strings are copied; each step costs the same as one undo().
+    //
+    bool undo_to(long m)
+    {
+        // IDs decrease down the stack, so m's record is above the first
+        // record with a smaller ID
+        Undo_node *node = undo_top;
+        while (node != nullptr && node->id > m)
+        {
+            node = node->next;
+        }
+        if (node == undo_top || (node == nullptr ? m != 0 : node->id != m))
+            return false;
+
+        while (undo_top != node)
+        {
+            undo();
+        }
+        return true;
     }
 
 }; // class Stringlist
@@ -328,7 +759,17 @@ public:
 //
 ostream &operator<<(ostream &os, const Stringlist &lst)
 {
-    return os << lst.to_string();
+    lst.write_to(os);
+    return os;
+}
+
+//
+// Swaps the contents and undo stacks of a and b; lets swap(a, b) (and code
+// that calls swap via std::swap) use the fast Stringlist::swap.
+//
+void swap(Stringlist &a, Stringlist &b) noexcept
+{
+    a.swap(b);
 }
 
 //
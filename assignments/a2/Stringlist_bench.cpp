@@ -0,0 +1,100 @@
+// Stringlist_bench.cpp
+
+//
+// Times the different ways of converting a large Stringlist to text:
+//
+//   - the original to_string, built with repeated +=
+//   - to_string, which reserves the exact length once
+//   - append_to, re-using the same output string each time
+//   - write_to (i.e. operator<<), which writes directly to a stream
+//
+// Compile and run like this:
+//
+//   > make Stringlist_bench
+//   > ./Stringlist_bench
+//
+
+#include "Stringlist.h"
+#include <cassert>
+#include <ctime>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+const int NUM_STRINGS = 1000000;
+const int NUM_TRIALS = 5;
+
+//
+// The original implementation of Stringlist::to_string, for comparison.
+//
+string concat_to_string(const Stringlist &lst)
+{
+    string result = "{";
+    for (int i = 0; i < lst.size(); i++)
+    {
+        if (i > 0)
+            result += ", ";
+        result += "\"" + lst.get(i) + "\"";
+    }
+    return result + "}";
+}
+
+//
+// Returns the CPU time, in seconds, per call of f averaged over NUM_TRIALS
+// calls.
+//
+template <typename F>
+double time_per_call(F f)
+{
+    clock_t start = clock();
+    for (int i = 0; i < NUM_TRIALS; i++)
+    {
+        f();
+    }
+    clock_t end = clock();
+    return double(end - start) / CLOCKS_PER_SEC / NUM_TRIALS;
+}
+
+void report(const string &name, double sec)
+{
+    cout << "   " << name << ": " << sec << " seconds" << endl;
+}
+
+int main()
+{
+    Stringlist lst;
+    for (int i = 0; i < NUM_STRINGS; i++)
+    {
+        lst.insert_back("word" + to_string(i));
+    }
+
+    const string expected = concat_to_string(lst);
+    assert(lst.to_string() == expected);
+
+    cout << "Converting a " << lst.size() << " string Stringlist ("
+         << expected.size() << " characters) to text:\n";
+
+    report("concatenation with +=", time_per_call([&]()
+                                                  { concat_to_string(lst); }));
+
+    report("to_string", time_per_call([&]()
+                                      { lst.to_string(); }));
+
+    string buffer;
+    report("append_to (re-used buffer)", time_per_call([&]()
+                                                       {
+                                                           buffer.clear();
+                                                           lst.append_to(buffer);
+                                                       }));
+    assert(buffer == expected);
+
+    ostringstream out;
+    report("write_to", time_per_call([&]()
+                                     {
+                                         out.str("");
+                                         lst.write_to(out);
+                                     }));
+    assert(out.str() == expected);
+} // main
@@ -0,0 +1,132 @@
+// Stringlist_latency.cpp
+
+//
+// Measures the latency of individual Stringlist operations on lists of size
+// 10, 100, 1000, ..., 10000000, and prints the results as comma separated
+// values (CSV):
+//
+//   operation, size, samples, p50_ns, p99_ns
+//
+// p50_ns is the median time in nanoseconds of one call, and p99_ns is the
+// 99th percentile. Every modifying operation is followed by an (untimed) undo
+// so that the list stays the same size, and so that the undo stack doesn't
+// grow.
+//
+// Compile and run like this:
+//
+//   > make Stringlist_latency
+//   > ./Stringlist_latency > latency.csv
+//
+// An optional command-line argument sets the largest list size, e.g.
+//
+//   > ./Stringlist_latency 100000
+//
+
+#include "Stringlist.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//
+// The total number of strings shifted per operation is roughly samples * n, so
+// the number of samples goes down as n goes up to keep the running time
+// reasonable.
+//
+const int MAX_SAMPLES = 1000;
+const int MIN_SAMPLES = 20;
+const long WORK_PER_OPERATION = 20000000;
+
+//
+// An iterator that generates the strings "word0", "word1", ..., so that
+// large lists can be built with a single call to insert_range without first
+// storing all the strings in another container.
+//
+struct Word_iter
+{
+    int i;
+
+    string operator*() const { return "word" + to_string(i); }
+    Word_iter &operator++()
+    {
+        i++;
+        return *this;
+    }
+    bool operator!=(const Word_iter &other) const { return i != other.i; }
+}; // struct Word_iter
+
+int num_samples(int n)
+{
+    long samples = WORK_PER_OPERATION / n;
+    return max(long(MIN_SAMPLES), min(long(MAX_SAMPLES), samples));
+}
+
+//
+// Calls before(), op(), and after() samples times, and prints the p50 and p99
+// times of the op() calls. Only op() is timed.
+//
+template <typename Before, typename Op, typename After>
+void measure(const string &name, int n, Before before, Op op, After after)
+{
+    int samples = num_samples(n);
+    vector<long> times_ns;
+    times_ns.reserve(samples);
+    for (int i = 0; i < samples; i++)
+    {
+        before();
+        auto start = chrono::steady_clock::now();
+        op();
+        auto end = chrono::steady_clock::now();
+        after();
+        times_ns.push_back(chrono::duration_cast<chrono::nanoseconds>(end - start).count());
+    }
+
+    sort(times_ns.begin(), times_ns.end());
+    long p50 = times_ns[(samples - 1) * 50 / 100];
+    long p99 = times_ns[(samples - 1) * 99 / 100];
+    cout << name << ", " << n << ", " << samples << ", " << p50 << ", " << p99 << endl;
+}
+
+void nothing() {}
+
+void measure_all(int n)
+{
+    Stringlist lst;
+    lst.insert_range(0, Word_iter{0}, Word_iter{n});
+    assert(lst.size() == n);
+
+    int mid = n / 2;
+    string last = lst.get(n - 1);
+    int found = -1;
+    auto undo = [&]() { lst.undo(); };
+
+    measure("insert_back", n, nothing, [&]() { lst.insert_back("new"); }, undo);
+    measure("insert_front", n, nothing, [&]() { lst.insert_front("new"); }, undo);
+    measure("insert_before(mid)", n, nothing, [&]() { lst.insert_before(mid, "new"); }, undo);
+    measure("remove_at(mid)", n, nothing, [&]() { lst.remove_at(mid); }, undo);
+    measure("index_of(last)", n, nothing, [&]() { found = lst.index_of(last); }, nothing);
+    measure("set(mid)", n, nothing, [&]() { lst.set(mid, "new"); }, undo);
+    measure("undo(set)", n, [&]() { lst.set(mid, "new"); }, undo, nothing);
+
+    assert(found == n - 1);
+    assert(lst.size() == n);
+}
+
+int main(int argc, char *argv[])
+{
+    int max_size = 10000000;
+    if (argc == 2)
+    {
+        max_size = stoi(argv[1]);
+    }
+
+    cout << "operation, size, samples, p50_ns, p99_ns" << endl;
+    for (long n = 10; n <= max_size; n *= 10)
+    {
+        measure_all(n);
+    }
+} // main
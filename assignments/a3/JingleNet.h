@@ -0,0 +1,542 @@
+// JingleNet.h
+
+//
+// The JingleNet announcement system described in README.md: one queue per
+// rank (NUM_RANKS, normally five), plus an index of the announcements each
+// sender has queued.
+//
+// Every queued announcement is stored in one Node that is linked onto two
+// doubly-linked lists at the same time:
+//
+//   - the rank queue for its rank
+//   - its sender's list for that rank, which is in the same order as the rank
+//     queue
+//
+// Since a node can be unlinked from both lists in O(1) time, REMOVE_ALL and
+// PROMOTE_ANNOUNCEMENTS cost O(k), where k is the number of announcements from
+// the sender, instead of O(total queued).
+//
+// Nodes are allocated from a Node_pool, which re-uses the memory of announced
+// and removed nodes, so that in a steady state SEND and ANNOUNCE don't call
+// new or delete.
+//
+// To keep nodes small, a node doesn't store an Announcement. Sender names are
+// "interned": each different name is stored once, and nodes refer to it by a
+// 32-bit sender ID. The rank is the rank of the node's queue. The text is
+// stored in a Text_arena.
+//
+// A sender is forgotten when their last announcement is removed, and their ID
+// is re-used for the next new name, so a long stream of short-lived senders
+// doesn't make the sender table grow.
+//
+
+#pragma once
+
+#include "Announcement.h"
+#include "JingleNet_announcer.h"
+#include "Text_arena.h"
+#include <cstdint>
+#include <deque>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+//
+// Returns the index of r in JingleNet's array of queues, i.e. 0 for
+// Rank::SNOWMAN up to NUM_RANKS - 1 for the highest rank.
+//
+int rank_index(Rank r)
+{
+    return int(r) - int(Rank::SNOWMAN);
+}
+
+Rank index_rank(int i)
+{
+    return Rank(i + int(Rank::SNOWMAN));
+}
+
+//
+// A set of rank indexes: bit i is 1 if and only if rank index i is in the
+// set. NUM_RANKS is at most 64, so every rank has a bit.
+//
+using Rank_mask = uint64_t;
+
+//
+// Returns the index of the highest 1 bit in mask, which must not be 0.
+// __builtin_clzll ("count leading zeros") is a g++/clang built-in that
+// compiles to a single instruction on most CPUs, so this takes the same time
+// no matter how many ranks there are.
+//
+int highest_bit(Rank_mask mask)
+{
+    return 63 - __builtin_clzll(mask);
+}
+
+//
+// A queued announcement, linked into both a rank queue and a sender list.
+// 48 bytes on a 64-bit system.
+//
+struct Node
+{
+    Node *prev = nullptr; // rank queue links
+    Node *next = nullptr;
+
+    Node *prev_by_sender = nullptr; // sender list links
+    Node *next_by_sender = nullptr;
+
+    uint32_t sender; // sender ID
+    Text_ref text;
+
+    Node(uint32_t sender, Text_ref text)
+        : sender(sender), text(text)
+    {
+    }
+}; // struct Node
+
+//
+// Allocates Nodes in blocks of NODES_PER_BLOCK, and keeps the memory of
+// destroyed nodes on a free list to be re-used by the next create.
+//
+class Node_pool
+{
+    static const int NODES_PER_BLOCK = 1024;
+
+    //
+    // A slot holds either a Node, or (when it's free) a pointer to the next
+    // free slot. A union stores all its members in the same memory, so a slot
+    // is only as big as a Node.
+    //
+    union Slot
+    {
+        Slot *next_free;
+        alignas(Node) unsigned char node[sizeof(Node)];
+    };
+
+    vector<Slot *> blocks;
+    Slot *free_list = nullptr;
+
+public:
+    Node_pool() {}
+
+    // a pool owns its blocks, so it should not be copied
+    Node_pool(const Node_pool &other) = delete;
+    Node_pool &operator=(const Node_pool &other) = delete;
+
+    //
+    // All nodes must be destroyed before the pool is.
+    //
+    ~Node_pool()
+    {
+        for (Slot *block : blocks)
+        {
+            delete[] block;
+        }
+    }
+
+    //
+    // Returns a new Node constructed from the given arguments.
+    //
+    // Args&&... args is a "parameter pack" that accepts any number of
+    // arguments of any type, and std::forward passes them on unchanged to the
+    // Node constructor.
+    //
+    template <typename... Args>
+    Node *create(Args &&...args)
+    {
+        if (free_list == nullptr)
+        {
+            Slot *block = new Slot[NODES_PER_BLOCK];
+            blocks.push_back(block);
+            for (int i = 0; i < NODES_PER_BLOCK; i++)
+            {
+                block[i].next_free = free_list;
+                free_list = &block[i];
+            }
+        }
+        Slot *slot = free_list;
+        free_list = slot->next_free;
+
+        // "placement new" constructs a Node in the slot's memory
+        return new (slot->node) Node(std::forward<Args>(args)...);
+    }
+
+    //
+    // Destroys n and puts its memory on the free list.
+    //
+    void destroy(Node *n)
+    {
+        n->~Node();
+        Slot *slot = reinterpret_cast<Slot *>(n);
+        slot->next_free = free_list;
+        free_list = slot;
+    }
+}; // class Node_pool
+
+//
+// A queue of the announcements of one rank, implemented as an intrusive
+// doubly-linked list, i.e. the links are stored in the nodes themselves. The
+// queue does not own its nodes. All operations are O(1).
+//
+class Rank_queue
+{
+    Node *head = nullptr; // front of the queue
+    Node *tail = nullptr; // back of the queue
+    int count = 0;
+
+public:
+    int size() const { return count; }
+    Node *front() const { return head; }
+
+    void enqueue(Node *n)
+    {
+        n->prev = tail;
+        n->next = nullptr;
+        if (tail == nullptr)
+            head = n;
+        else
+            tail->next = n;
+        tail = n;
+        count++;
+    }
+
+    void unlink(Node *n)
+    {
+        if (n->prev == nullptr)
+            head = n->next;
+        else
+            n->prev->next = n->next;
+        if (n->next == nullptr)
+            tail = n->prev;
+        else
+            n->next->prev = n->prev;
+        count--;
+    }
+}; // class Rank_queue
+
+//
+// A list of one sender's announcements of one rank, in the same order as they
+// appear in the rank queue. Same as Rank_queue, but uses the *_by_sender
+// links.
+//
+struct Sender_list
+{
+    Node *head = nullptr;
+    Node *tail = nullptr;
+    int count = 0;
+
+    void push_back(Node *n)
+    {
+        n->prev_by_sender = tail;
+        n->next_by_sender = nullptr;
+        if (tail == nullptr)
+            head = n;
+        else
+            tail->next_by_sender = n;
+        tail = n;
+        count++;
+    }
+
+    void unlink(Node *n)
+    {
+        if (n->prev_by_sender == nullptr)
+            head = n->next_by_sender;
+        else
+            n->prev_by_sender->next_by_sender = n->next_by_sender;
+        if (n->next_by_sender == nullptr)
+            tail = n->prev_by_sender;
+        else
+            n->next_by_sender->prev_by_sender = n->prev_by_sender;
+        count--;
+    }
+}; // struct Sender_list
+
+//
+// A sender's name, and all their queued announcements by rank.
+//
+struct Sender
+{
+    string name;
+    Sender_list by_rank[NUM_RANKS];
+    int count = 0; // total over all ranks
+};
+
+class JingleNet
+{
+    Node_pool pool; // declared first so it's destroyed last
+    Text_arena texts;
+    Rank_queue queues[NUM_RANKS]; // queues[rank_index(r)] has rank r
+    Rank_mask occupied = 0;       // bit r is 1 if and only if queues[r] is non-empty
+
+    //
+    // senders[id] is the sender with that ID. A deque never moves its
+    // elements when it grows, so the keys of sender_ids can be string_views of
+    // the names in senders. free_ids are the IDs of forgotten senders, whose
+    // Sender records are waiting to be re-used.
+    //
+    deque<Sender> senders;
+    unordered_map<string_view, uint32_t> sender_ids;
+    vector<uint32_t> free_ids;
+
+    //
+    // Returns the ID of the sender with the given name, adding a new sender
+    // the first time a name is seen.
+    //
+    uint32_t intern(string_view name)
+    {
+        auto it = sender_ids.find(name);
+        if (it != sender_ids.end())
+            return it->second;
+
+        uint32_t id;
+        if (free_ids.empty())
+        {
+            id = senders.size();
+            senders.emplace_back();
+        }
+        else
+        {
+            id = free_ids.back();
+            free_ids.pop_back();
+        }
+        senders[id].name = name;
+        sender_ids.emplace(senders[id].name, id);
+        return id;
+    }
+
+    //
+    // Forgets the sender with the given ID, who must have no announcements
+    // queued, so that the ID can be re-used.
+    //
+    void forget(uint32_t id)
+    {
+        sender_ids.erase(senders[id].name);
+        senders[id].name.clear();
+        free_ids.push_back(id);
+    }
+
+    //
+    // Links n onto the back of queue r and its sender's list for rank r.
+    //
+    void link(Node *n, int r)
+    {
+        queues[r].enqueue(n);
+        occupied |= Rank_mask(1) << r;
+        Sender &s = senders[n->sender];
+        s.by_rank[r].push_back(n);
+        s.count++;
+    }
+
+    //
+    // Unlinks n (of rank r) from its queue and sender list.
+    //
+    void unlink(Node *n, int r)
+    {
+        queues[r].unlink(n);
+        if (queues[r].size() == 0)
+            occupied &= ~(Rank_mask(1) << r);
+        Sender &s = senders[n->sender];
+        s.by_rank[r].unlink(n);
+        s.count--;
+    }
+
+    //
+    // Unlinks n (of rank r) and deletes it. If it was its sender's last
+    // announcement, the sender is forgotten. (unlink doesn't do this, since
+    // PROMOTE_ANNOUNCEMENTS unlinks and re-links a sender's nodes.)
+    //
+    void remove(Node *n, int r)
+    {
+        uint32_t id = n->sender;
+        unlink(n, r);
+        texts.release(n->text);
+        pool.destroy(n);
+        if (senders[id].count == 0)
+            forget(id);
+    }
+
+public:
+    JingleNet() {}
+
+    // a JingleNet owns its nodes, so it should not be copied
+    JingleNet(const JingleNet &other) = delete;
+    JingleNet &operator=(const JingleNet &other) = delete;
+
+    ~JingleNet()
+    {
+        for (int r = 0; r < NUM_RANKS; r++)
+        {
+            while (queues[r].size() > 0)
+            {
+                Node *n = queues[r].front();
+                queues[r].unlink(n);
+                pool.destroy(n);
+            }
+        }
+    }
+
+    //
+    // Returns the number of announcements in the system.
+    //
+    int size() const
+    {
+        int total = 0;
+        for (int r = 0; r < NUM_RANKS; r++)
+        {
+            total += queues[r].size();
+        }
+        return total;
+    }
+
+    //
+    // Returns the number of different senders with queued announcements.
+    //
+    int num_senders() const { return sender_ids.size(); }
+
+    //
+    // Returns the number of Sender records held, including the ones waiting
+    // to be re-used. This is the most senders that have had announcements
+    // queued at the same time.
+    //
+    int sender_records() const { return senders.size(); }
+
+    //
+    // Calls f(sender_name, rank, text) for every queued announcement, lowest
+    // rank first, and in queue order within each rank. Sending them in this
+    // order to an empty JingleNet makes an exact copy of this one.
+    //
+    template <typename F>
+    void for_each(F f) const
+    {
+        for (int r = 0; r < NUM_RANKS; r++)
+        {
+            for (Node *n = queues[r].front(); n != nullptr; n = n->next)
+            {
+                f(string_view(senders[n->sender].name), index_rank(r), texts.get(n->text));
+            }
+        }
+    }
+
+    //
+    // SEND: adds an announcement to the back of the queue for its rank. The
+    // sender name and text are copied, so they only need to last until send
+    // returns.
+    //
+    void send(string_view sender_name, Rank rank, string_view text)
+    {
+        Node *n = pool.create(intern(sender_name), texts.add(text));
+        link(n, rank_index(rank));
+    }
+
+    void send(const Announcement &a)
+    {
+        send(a.get_sender_name(), a.get_rank(), a.get_text());
+    }
+
+    //
+    // REMOVE_ALL: removes every announcement from sender. O(k), where k is
+    // the number of announcements from sender.
+    //
+    void remove_all(string_view sender)
+    {
+        auto it = sender_ids.find(sender);
+        if (it == sender_ids.end())
+            return;
+
+        Sender &s = senders[it->second];
+        for (int r = 0; r < NUM_RANKS; r++)
+        {
+            while (s.by_rank[r].head != nullptr)
+            {
+                remove(s.by_rank[r].head, r);
+            }
+        }
+    }
+
+    //
+    // PROMOTE_ANNOUNCEMENTS: moves every announcement from sender to the back
+    // of the queue one rank higher, starting with the second-highest queue and
+    // working down. Announcements in the highest queue are not changed. O(k),
+    // where k is the number of announcements from sender.
+    //
+    // Nodes don't store their rank, so a node is promoted by just re-linking
+    // it, without copying its text.
+    //
+    void promote_announcements(string_view sender)
+    {
+        auto it = sender_ids.find(sender);
+        if (it == sender_ids.end())
+            return;
+
+        Sender &s = senders[it->second];
+        for (int r = NUM_RANKS - 2; r >= 0; r--)
+        {
+            // s.by_rank[r] is in queue order, so the promoted announcements
+            // keep their relative order in queue r + 1
+            while (s.by_rank[r].head != nullptr)
+            {
+                Node *n = s.by_rank[r].head;
+                unlink(n, r);
+                link(n, r + 1);
+            }
+        }
+    }
+
+    //
+    // ANNOUNCE: announces (and removes) the next n announcements, highest rank
+    // first.
+    //
+    // The highest non-empty queue is found from the occupied mask with one
+    // count-leading-zeros instruction, instead of checking the queues one at
+    // a time from the top.
+    //
+    // Uses jnet.announce_batch, so the announcements are buffered and written
+    // to announcements.txt in large blocks instead of one line at a time.
+    //
+    void announce(int n)
+    {
+        while (n > 0 && occupied != 0)
+        {
+            int r = highest_bit(occupied);
+            Node *front = queues[r].front();
+            jnet.announce_batch(senders[front->sender].name, index_rank(r),
+                                texts.get(front->text));
+            remove(front, r);
+            n--;
+        }
+    }
+
+    //
+    // Runs one JingleNet command, e.g. "SEND greenie elf2 send candy canes".
+    // Blank lines are ignored. Throws a runtime_error if the command is
+    // unknown.
+    //
+    void run(string_view line)
+    {
+        if (line.empty())
+            return;
+
+        size_t pos = line.find(' ');
+        string_view command = line.substr(0, pos);
+        string_view arg = pos == string_view::npos ? "" : line.substr(pos + 1);
+
+        if (command == "SEND")
+        {
+            Announcement_fields f = parse_announcement(arg);
+            send(f.sender_name, f.rank, f.text);
+        }
+        else if (command == "REMOVE_ALL")
+            remove_all(arg);
+        else if (command == "PROMOTE_ANNOUNCEMENTS")
+            promote_announcements(arg);
+        else if (command == "ANNOUNCE")
+            announce(stoi(string(arg)));
+        else
+            throw runtime_error("JingleNet: unknown command \"" + string(line) + "\"");
+    }
+}; // class JingleNet
@@ -0,0 +1,360 @@
+// JingleNet_concurrent.h
+
+//
+// A multi-threaded JingleNet. Any number of sender threads submit commands,
+// and one announcer thread (started by the constructor) runs them on a
+// JingleNet that only it touches. The JingleNet keeps its queues in strict
+// rank priority, and ANNOUNCE finds the highest non-empty one from its
+// occupied mask.
+//
+// Each sender thread gets its own lock-free Mpsc_queue the first time it
+// submits a command, and all of its commands go into that queue in the order
+// they were submitted. After pushing, a sender sets its queue's bit in the
+// "pending" mask with one atomic operation, so submitting never blocks on the
+// announcer or on other senders. The announcer atomically takes the whole
+// mask and drains the pending queues. (With more than 64 sender threads,
+// queues i, i + 64, i + 128, ... share bit i.)
+//
+// Since a queue has only one sender, a command can't be hidden behind another
+// sender's half-finished push (see Mpsc_queue.h): once a command is visible,
+// so is every command its sender submitted before it.
+//
+// Two modes:
+//
+//   - free-running (the default): each thread's commands run in the order
+//     that thread submitted them, but commands from different threads are
+//     interleaved in whatever order the announcer receives them. With one
+//     sender thread, announcements.txt is the same as from a single-threaded
+//     JingleNet; with more, it can differ from run to run.
+//
+//   - deterministic: every command is submitted with its sequence number,
+//     i.e. its position (starting at 0) in the command log. The announcer
+//     holds back commands that arrive early, and runs them in sequence
+//     order, so announcements.txt is exactly the same as running the log on
+//     a single-threaded JingleNet, no matter how the commands are split among
+//     the sender threads.
+//
+
+#pragma once
+
+#include "Announcement.h"
+#include "JingleNet.h"
+#include "JingleNet_announcer.h"
+#include "Mpsc_queue.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+class JingleNet_concurrent
+{
+    struct Command
+    {
+        enum class Kind
+        {
+            SEND,
+            REMOVE_ALL,
+            PROMOTE_ANNOUNCEMENTS,
+            ANNOUNCE,
+            STOP
+        };
+
+        Kind kind;
+        long seq;                          // only used in deterministic mode
+        optional<Announcement> announcement; // SEND
+        string sender;                     // REMOVE_ALL, PROMOTE_ANNOUNCEMENTS
+        int n = 0;                         // ANNOUNCE
+    };
+
+    //
+    // inboxes[i] is the queue of the i-th sender thread to submit a command.
+    // New inboxes are added under inbox_mutex; the announcer keeps its own
+    // copy of the list, and re-reads it when num_inboxes changes.
+    //
+    mutex inbox_mutex;
+    vector<unique_ptr<Mpsc_queue<Command>>> inboxes;
+    map<thread::id, int> inbox_index;
+    atomic<int> num_inboxes{0};
+    atomic<uint64_t> pending{0}; // bit i % 64 is for inboxes[i]
+
+    // each JingleNet_concurrent gets a different ID, so a thread's cached
+    // inbox isn't mistaken for one in a later object at the same address
+    inline static atomic<long> next_id{0};
+    const long id = next_id++;
+
+    // used only to put the announcer to sleep when there is nothing to do
+    mutex sleep_mutex;
+    condition_variable wake_up;
+    atomic<bool> sleeping{false};
+
+    // the rest is only used by the announcer thread
+    bool deterministic;
+    JingleNet net;
+    vector<Mpsc_queue<Command> *> announcer_inboxes;
+    map<long, Command> early; // deterministic mode: commands that came too soon
+    long next_seq = 0;
+    bool stopped = false;
+
+    thread announcer; // declared last so it starts after the rest is ready
+
+    struct Inbox_ref
+    {
+        Mpsc_queue<Command> *queue;
+        int index;
+    };
+
+    //
+    // Returns the calling thread's inbox, adding one the first time the
+    // thread submits a command. It's cached in a thread_local variable (one
+    // per thread), so the mutex is only locked when a thread starts using a
+    // different JingleNet_concurrent.
+    //
+    Inbox_ref my_inbox()
+    {
+        thread_local long cached_id = -1;
+        thread_local Inbox_ref cached;
+        if (cached_id != id)
+        {
+            lock_guard<mutex> lock(inbox_mutex);
+            auto it = inbox_index.find(this_thread::get_id());
+            if (it == inbox_index.end())
+            {
+                it = inbox_index.emplace(this_thread::get_id(), inboxes.size()).first;
+                inboxes.push_back(make_unique<Mpsc_queue<Command>>());
+                num_inboxes.store(inboxes.size());
+            }
+            cached_id = id;
+            cached = {inboxes[it->second].get(), it->second};
+        }
+        return cached;
+    }
+
+    //
+    // Adds c to the calling thread's inbox, and tells the announcer it's
+    // there.
+    //
+    void submit(Command c)
+    {
+        if (deterministic && c.seq < 0 && c.kind != Command::Kind::STOP)
+            throw runtime_error("JingleNet_concurrent: deterministic mode needs sequence numbers");
+        Inbox_ref inbox = my_inbox();
+        inbox.queue->push(std::move(c));
+        pending.fetch_or(uint64_t(1) << (inbox.index % 64));
+        if (sleeping.load())
+        {
+            lock_guard<mutex> lock(sleep_mutex);
+            wake_up.notify_one();
+        }
+    }
+
+    void apply(Command &c)
+    {
+        switch (c.kind)
+        {
+        case Command::Kind::SEND:
+            net.send(std::move(*c.announcement));
+            break;
+        case Command::Kind::REMOVE_ALL:
+            net.remove_all(c.sender);
+            break;
+        case Command::Kind::PROMOTE_ANNOUNCEMENTS:
+            net.promote_announcements(c.sender);
+            break;
+        case Command::Kind::ANNOUNCE:
+            net.announce(c.n);
+            break;
+        case Command::Kind::STOP:
+            stopped = true;
+            break;
+        }
+    }
+
+    //
+    // Runs c now, or in deterministic mode, as soon as every command before it
+    // has run.
+    //
+    void handle(Command c)
+    {
+        // a STOP without a sequence number comes from the destructor
+        if (!deterministic || c.seq < 0)
+        {
+            apply(c);
+            return;
+        }
+
+        if (c.seq != next_seq)
+        {
+            early.emplace(c.seq, std::move(c));
+            return;
+        }
+        apply(c);
+        next_seq++;
+        while (!early.empty() && early.begin()->first == next_seq)
+        {
+            apply(early.begin()->second);
+            early.erase(early.begin());
+            next_seq++;
+        }
+    }
+
+    //
+    // Handles everything in the inboxes whose bits are set in mask. Returns
+    // true if any commands were handled.
+    //
+    bool drain_inboxes(uint64_t mask)
+    {
+        // a sender adds its inbox before setting its bit, so any inbox with a
+        // bit in mask is in the list after this
+        if (announcer_inboxes.size() != num_inboxes.load())
+        {
+            lock_guard<mutex> lock(inbox_mutex);
+            announcer_inboxes.clear();
+            for (auto &q : inboxes)
+            {
+                announcer_inboxes.push_back(q.get());
+            }
+        }
+
+        bool any = false;
+        for (int i = 0; i < announcer_inboxes.size(); i++)
+        {
+            if ((mask >> (i % 64) & 1) == 0)
+                continue;
+            while (optional<Command> c = announcer_inboxes[i]->pop())
+            {
+                handle(std::move(*c));
+                any = true;
+            }
+        }
+        return any;
+    }
+
+    void announcer_loop()
+    {
+        while (!stopped)
+        {
+            bool any = drain_inboxes(pending.exchange(0));
+            if (!any && !stopped)
+            {
+                // A sender sets its bit before checking sleeping, and we set
+                // sleeping before checking the bits, so either the sender
+                // sees sleeping and wakes us, or we see its bit and don't
+                // wait.
+                unique_lock<mutex> lock(sleep_mutex);
+                sleeping.store(true);
+                wake_up.wait(lock, [this] { return pending.load() != 0; });
+                sleeping.store(false);
+            }
+        }
+
+        // The STOP may have been handled before commands that other threads
+        // submitted before finish was called, e.g. if their inboxes come
+        // later in the list, so run those too.
+        drain_inboxes(~uint64_t(0));
+        jnet.flush();
+    }
+
+public:
+    //
+    // Starts the announcer thread.
+    //
+    JingleNet_concurrent(bool deterministic = false)
+        : deterministic(deterministic), announcer([this] { announcer_loop(); })
+    {
+    }
+
+    JingleNet_concurrent(const JingleNet_concurrent &other) = delete;
+    JingleNet_concurrent &operator=(const JingleNet_concurrent &other) = delete;
+
+    ~JingleNet_concurrent()
+    {
+        // in deterministic mode, commands still waiting for an earlier
+        // sequence number are dropped
+        finish();
+    }
+
+    //
+    // The methods below can be called from any number of threads at the same
+    // time. In deterministic mode, seq must be the command's position in the
+    // command log; otherwise it is ignored.
+    //
+
+    void send(Announcement a, long seq = -1)
+    {
+        submit(Command{Command::Kind::SEND, seq, std::move(a), "", 0});
+    }
+
+    void remove_all(string sender, long seq = -1)
+    {
+        submit(Command{Command::Kind::REMOVE_ALL, seq, nullopt, std::move(sender), 0});
+    }
+
+    void promote_announcements(string sender, long seq = -1)
+    {
+        submit(Command{Command::Kind::PROMOTE_ANNOUNCEMENTS, seq, nullopt, std::move(sender), 0});
+    }
+
+    void announce(int n, long seq = -1)
+    {
+        submit(Command{Command::Kind::ANNOUNCE, seq, nullopt, "", n});
+    }
+
+    //
+    // Submits one JingleNet command, e.g. "SEND greenie elf2 send candy
+    // canes". Same as JingleNet::run: blank lines are ignored (and don't use
+    // up a sequence number), and unknown commands throw a runtime_error in the
+    // calling thread.
+    //
+    void run(string_view line, long seq = -1)
+    {
+        if (line.empty())
+            return;
+
+        size_t pos = line.find(' ');
+        string_view command = line.substr(0, pos);
+        string_view arg = pos == string_view::npos ? "" : line.substr(pos + 1);
+
+        if (command == "SEND")
+            send(Announcement(arg), seq);
+        else if (command == "REMOVE_ALL")
+            remove_all(string(arg), seq);
+        else if (command == "PROMOTE_ANNOUNCEMENTS")
+            promote_announcements(string(arg), seq);
+        else if (command == "ANNOUNCE")
+            announce(stoi(string(arg)), seq);
+        else
+            throw runtime_error("JingleNet: unknown command \"" + string(line) + "\"");
+    }
+
+    //
+    // Waits for the announcer to run every submitted command, flush
+    // announcements.txt and stop. Call it once, after all the sender threads
+    // are done submitting. In deterministic mode, num_commands is the number
+    // of commands in the log, and sequence numbers 0 to num_commands - 1 must
+    // all have been submitted; if num_commands is left out then commands
+    // still waiting for an earlier sequence number are dropped.
+    //
+    void finish(long num_commands = -1)
+    {
+        if (!announcer.joinable())
+            return;
+        submit(Command{Command::Kind::STOP, num_commands, nullopt, "", 0});
+        announcer.join();
+    }
+
+    //
+    // Returns the number of queued announcements. Only call it after finish.
+    //
+    int size() const { return net.size(); }
+}; // class JingleNet_concurrent
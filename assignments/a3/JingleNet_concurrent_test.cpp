@@ -0,0 +1,199 @@
+// JingleNet_concurrent_test.cpp
+
+#include "JingleNet_concurrent.h"
+#include "Line_reader.h"
+#include <cassert>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+struct Test
+{
+    string name;
+    Test(const string &name)
+        : name(name)
+    {
+        cout << "Calling " << name << " ...\n";
+    }
+
+    ~Test()
+    {
+        cout << "... " << name << " done: all tests passed\n";
+    }
+}; // struct Test
+
+string read_file(const string &filename)
+{
+    ifstream in(filename);
+    stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+//
+// Returns the non-blank lines of filename.
+//
+vector<string> read_lines(const string &filename)
+{
+    vector<string> lines;
+    Line_reader reader(filename);
+    assert(reader.is_open());
+    string_view line;
+    while (reader.next(line))
+    {
+        if (!line.empty())
+            lines.emplace_back(line);
+    }
+    return lines;
+}
+
+//
+// Returns announcements (in the announcements.txt format) with offset added
+// to each announcement's number.
+//
+string renumbered(const string &announcements, int offset)
+{
+    string result;
+    stringstream in(announcements);
+    string line;
+    while (getline(in, line))
+    {
+        size_t colon = line.find(':');
+        result += to_string(stoi(line.substr(0, colon)) + offset);
+        result += line.substr(colon);
+        result += '\n';
+    }
+    return result;
+}
+
+//
+// Each thread alternates REMOVE_ALL and SEND for its own sender, ending with
+// a SEND. If every thread's commands run in the order it submitted them, then
+// exactly one announcement per thread is left.
+//
+void test_thread_order()
+{
+    Test("test_thread_order");
+    const int num_threads = 4;
+    JingleNet_concurrent net;
+    vector<thread> senders;
+    for (int t = 0; t < num_threads; t++)
+    {
+        senders.emplace_back([&, t] {
+            string name = "sender" + to_string(t);
+            for (int i = 0; i < 20000; i++)
+            {
+                net.remove_all(name);
+                net.send(Announcement(name, Rank(i % NUM_RANKS + 1), "message " + to_string(i)));
+                if (i % 7 == 0)
+                    net.promote_announcements(name);
+            }
+        });
+    }
+    for (thread &s : senders)
+    {
+        s.join();
+    }
+    net.finish();
+    assert(net.size() == num_threads);
+}
+
+//
+// With one sender thread, free-running mode gives exactly the same
+// announcements as a single-threaded JingleNet. This must be the first test
+// that announces anything, since jnet numbers announcements for the whole
+// program.
+//
+void test_one_thread_matches_sequential()
+{
+    Test("test_one_thread_matches_sequential");
+    {
+        JingleNet_concurrent net;
+        Line_reader reader("jinglenet_input5.txt");
+        assert(reader.is_open());
+        string_view line;
+        while (reader.next(line))
+        {
+            net.run(line);
+        }
+        net.finish();
+    }
+    assert(read_file(outfile_name) == read_file("output5.txt"));
+}
+
+//
+// In deterministic mode, the commands of a log can be submitted by several
+// threads in any order, and the announcements are the same as when a
+// single-threaded JingleNet runs the log. Since earlier tests have already
+// announced, the new part of announcements.txt is compared with the sample
+// output renumbered to follow on from them.
+//
+void test_deterministic_matches_sequential()
+{
+    Test("test_deterministic_matches_sequential");
+    const int num_threads = 4;
+    vector<string> log = read_lines("jinglenet_input5.txt");
+    int count_before = jnet.count();
+    long long bytes_before = jnet.bytes_written();
+    {
+        JingleNet_concurrent net(true);
+        vector<thread> senders;
+        for (int t = 0; t < num_threads; t++)
+        {
+            // thread t submits commands t, t + num_threads, ..., in reverse
+            // order, so most of them arrive before the commands they follow
+            senders.emplace_back([&, t] {
+                for (long i = log.size() - 1; i >= 0; i--)
+                {
+                    if (i % num_threads == t)
+                        net.run(log[i], i);
+                }
+            });
+        }
+        for (thread &s : senders)
+        {
+            s.join();
+        }
+        net.finish(log.size());
+    }
+    string announced = read_file(outfile_name).substr(bytes_before);
+    assert(announced == renumbered(read_file("output5.txt"), count_before));
+}
+
+//
+// In deterministic mode, a command without a sequence number can't be put in
+// order, so it's rejected.
+//
+void test_deterministic_needs_seq()
+{
+    Test("test_deterministic_needs_seq");
+    JingleNet_concurrent net(true);
+    bool threw = false;
+    try
+    {
+        net.send(Announcement("greenie", Rank::ELF2, "send candy canes"));
+    }
+    catch (const runtime_error &)
+    {
+        threw = true;
+    }
+    assert(threw);
+    net.finish(0);
+    assert(net.size() == 0);
+}
+
+int main()
+{
+    test_thread_order();
+    test_one_thread_matches_sequential();
+    test_deterministic_matches_sequential();
+    test_deterministic_needs_seq();
+
+    cout << "\nAll JingleNet_concurrent tests passed!\n";
+} // main
@@ -0,0 +1,611 @@
+// JingleNet_journal.h
+
+//
+// Crash recovery for JingleNet. A JingleNet_journal runs commands on a
+// JingleNet, and records them so that if the program dies part way through,
+// the next run can recover the queued announcements and announcements.txt,
+// and carry on from where the last run left off.
+//
+// Two files are used:
+//
+//   - jinglenet.wal, the journal (or "write-ahead log"): an append-only
+//     binary file of the commands that have been run. Each command is
+//     encoded into an in-memory batch *before* it is run. Batches are
+//     written to the journal together ("group commit"), every commit_every
+//     commands, so the cost of waiting for the disk (fsync) is shared by the
+//     whole batch. If the program dies, only the commands since the last
+//     commit are lost.
+//
+//   - jinglenet.snap, a snapshot: every queued announcement, in queue order,
+//     written every snapshot_every commands. After a snapshot the journal is
+//     started over, so recovery only has to load the snapshot and replay at
+//     most snapshot_every commands, no matter how long the history is.
+//
+// announcements.txt is synced to the disk before each commit, and each
+// commit records its size. Recovery cuts announcements.txt back to that
+// size, so it never has announcements from commands that were lost, and
+// replays the journal with announcing muted, so no announcement is written
+// twice.
+//
+// New files are written under a temporary name, synced, and then renamed, so
+// a crash leaves either the old file or the new one, never half of one.
+// Each block of the journal and snapshot has a checksum, so a batch that
+// was only partly written when the program died is detected and ignored.
+//
+
+#pragma once
+
+#include "Announcement.h"
+#include "JingleNet.h"
+#include "JingleNet_announcer.h"
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+
+using namespace std;
+
+const string journal_name = "jinglenet.wal";
+const string snapshot_name = "jinglenet.snap";
+
+//
+// Appends x to out as raw bytes. Numbers are stored in the computer's own
+// byte order, so the files can't be moved to a computer with a different
+// byte order.
+//
+template <typename T>
+void put(string &out, T x)
+{
+    out.append(reinterpret_cast<const char *>(&x), sizeof(x));
+}
+
+void put_string(string &out, string_view s)
+{
+    put<uint32_t>(out, s.size());
+    out += s;
+}
+
+//
+// Reads values from the front of a block of bytes. Reading past the end
+// throws a runtime_error.
+//
+class Byte_reader
+{
+    string_view data;
+
+    void need(size_t n)
+    {
+        if (data.size() < n)
+            throw runtime_error("JingleNet_journal: unexpected end of data");
+    }
+
+public:
+    Byte_reader(string_view data) : data(data) {}
+
+    size_t remaining() const { return data.size(); }
+
+    template <typename T>
+    T get()
+    {
+        need(sizeof(T));
+        T x;
+        memcpy(&x, data.data(), sizeof(T));
+        data.remove_prefix(sizeof(T));
+        return x;
+    }
+
+    string_view get_bytes(size_t n)
+    {
+        need(n);
+        string_view result = data.substr(0, n);
+        data.remove_prefix(n);
+        return result;
+    }
+
+    string_view get_string() { return get_bytes(get<uint32_t>()); }
+}; // class Byte_reader
+
+//
+// The 32-bit FNV-1a hash of s, used to detect damaged or partly written
+// data.
+//
+uint32_t checksum(string_view s)
+{
+    uint32_t h = 2166136261u;
+    for (char c : s)
+    {
+        h = (h ^ (unsigned char)c) * 16777619u;
+    }
+    return h;
+}
+
+//
+// A frame is a 4-byte payload size, a 4-byte checksum, and then the payload.
+//
+const size_t FRAME_HEADER_SIZE = 8;
+
+void put_frame(string &out, string_view payload)
+{
+    put<uint32_t>(out, payload.size());
+    put<uint32_t>(out, checksum(payload));
+    out += payload;
+}
+
+//
+// Reads a frame from in into payload. Returns false, without reading
+// anything, if in doesn't start with a complete frame with a correct
+// checksum.
+//
+bool get_frame(Byte_reader &in, string_view &payload)
+{
+    if (in.remaining() < FRAME_HEADER_SIZE)
+        return false;
+    Byte_reader header = in;
+    uint32_t size = header.get<uint32_t>();
+    uint32_t sum = header.get<uint32_t>();
+    if (header.remaining() < size)
+        return false;
+    string_view p = header.get_bytes(size);
+    if (checksum(p) != sum)
+        return false;
+    in = header;
+    payload = p;
+    return true;
+}
+
+string read_file(const string &name)
+{
+    ifstream in(name, ios::binary);
+    return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+void write_all(int fd, string_view data)
+{
+    while (!data.empty())
+    {
+        ssize_t n = ::write(fd, data.data(), data.size());
+        if (n < 0)
+            throw runtime_error("JingleNet_journal: write failed");
+        data.remove_prefix(n);
+    }
+}
+
+void sync_fd(int fd)
+{
+    if (fsync(fd) != 0)
+        throw runtime_error("JingleNet_journal: fsync failed");
+}
+
+//
+// Closes a file descriptor when it goes out of scope, so it isn't leaked if
+// an exception is thrown while it's open.
+//
+struct Fd_closer
+{
+    int fd;
+    ~Fd_closer()
+    {
+        if (fd >= 0)
+            ::close(fd);
+    }
+};
+
+//
+// Replaces the file name with data, so that after a crash the file is
+// either all old or all new.
+//
+void replace_file(const string &name, string_view data)
+{
+    string tmp = name + ".tmp";
+    {
+        int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0)
+            throw runtime_error("JingleNet_journal: could not create " + tmp);
+        Fd_closer closer{fd};
+        write_all(fd, data);
+        sync_fd(fd);
+    }
+    filesystem::rename(tmp, name);
+
+    // the rename itself is stored in the directory, which must be synced too
+    int dir = ::open(".", O_RDONLY);
+    Fd_closer dir_closer{dir};
+    if (dir >= 0)
+        fsync(dir);
+}
+
+class JingleNet_journal
+{
+    static constexpr string_view JOURNAL_MAGIC = "JNWAL01\n";
+    static constexpr string_view SNAPSHOT_MAGIC = "JNSNAP1\n";
+
+    enum Command : uint8_t
+    {
+        SEND,
+        REMOVE_ALL,
+        PROMOTE_ANNOUNCEMENTS,
+        ANNOUNCE
+    };
+
+    //
+    // A committed batch is a frame whose payload is:
+    //
+    //   uint32_t number of commands
+    //   uint32_t announcement count after the batch
+    //   uint64_t size of announcements.txt after the batch
+    //   the encoded commands
+    //
+    // batch holds the whole frame as it's built, with the frame header and
+    // these fields left blank until commit fills them in.
+    //
+    static const size_t BATCH_HEADER_SIZE = FRAME_HEADER_SIZE + 16;
+
+    JingleNet net;
+    long commit_every;
+    long snapshot_every;
+
+    int fd = -1; // the journal, open for appending
+    string batch;
+    long batch_count = 0; // number of commands in batch
+    long num_run = 0;     // number of commands run so far
+    long snapshot_at = 0; // num_run when the last snapshot was taken
+
+    //
+    // Decodes the next command from in and runs it.
+    //
+    void apply(Byte_reader &in)
+    {
+        switch (in.get<uint8_t>())
+        {
+        case SEND:
+        {
+            string_view sender = in.get_string();
+            Rank rank = Rank(in.get<uint8_t>());
+            string_view text = in.get_string();
+            net.send(sender, rank, text);
+            break;
+        }
+        case REMOVE_ALL:
+            net.remove_all(in.get_string());
+            break;
+        case PROMOTE_ANNOUNCEMENTS:
+            net.promote_announcements(in.get_string());
+            break;
+        case ANNOUNCE:
+            net.announce(in.get<uint32_t>());
+            break;
+        default:
+            throw runtime_error("JingleNet_journal: unknown command in journal");
+        }
+    }
+
+    //
+    // Starts a new, empty journal for commands from number first on.
+    //
+    void start_journal(long first)
+    {
+        if (fd >= 0)
+            ::close(fd);
+        string header(JOURNAL_MAGIC);
+        string payload;
+        put<uint64_t>(payload, first);
+        put_frame(header, payload);
+        replace_file(journal_name, header);
+        open_journal();
+    }
+
+    void open_journal()
+    {
+        fd = ::open(journal_name.c_str(), O_WRONLY | O_APPEND);
+        if (fd < 0)
+            throw runtime_error("JingleNet_journal: could not open " + journal_name);
+    }
+
+    //
+    // Loads the snapshot into net, and returns the announcement count and
+    // announcements.txt size at the time it was taken.
+    //
+    void load_snapshot(int &count, long long &bytes)
+    {
+        string data = read_file(snapshot_name);
+        Byte_reader in(data);
+        string_view payload;
+        if (in.get_bytes(SNAPSHOT_MAGIC.size()) != SNAPSHOT_MAGIC || !get_frame(in, payload))
+            throw runtime_error("JingleNet_journal: " + snapshot_name + " is damaged");
+
+        Byte_reader snap(payload);
+        num_run = snapshot_at = snap.get<uint64_t>();
+        count = snap.get<uint32_t>();
+        bytes = snap.get<uint64_t>();
+        if (snap.get<uint32_t>() != NUM_RANKS)
+            throw runtime_error("JingleNet_journal: snapshot has a different number of ranks");
+        uint64_t size = snap.get<uint64_t>();
+        for (uint64_t i = 0; i < size; i++)
+        {
+            string_view sender = snap.get_string();
+            Rank rank = Rank(snap.get<uint8_t>());
+            string_view text = snap.get_string();
+            net.send(sender, rank, text);
+        }
+    }
+
+    //
+    // Replays the journal's commands that aren't already in the snapshot.
+    // Stops at the first damaged batch (the one being written when the
+    // program died), and cuts it off the journal so new batches go right
+    // after the last good one.
+    //
+    void replay_journal(int &count, long long &bytes)
+    {
+        string data = read_file(journal_name);
+        Byte_reader in(data);
+        string_view payload;
+        if (in.get_bytes(JOURNAL_MAGIC.size()) != JOURNAL_MAGIC || !get_frame(in, payload))
+            throw runtime_error("JingleNet_journal: " + journal_name + " is damaged");
+        long next = Byte_reader(payload).get<uint64_t>(); // number of the next command
+        if (next > num_run)
+            throw runtime_error("JingleNet_journal: " + journal_name + " doesn't match the snapshot");
+
+        while (get_frame(in, payload))
+        {
+            Byte_reader b(payload);
+            uint32_t n = b.get<uint32_t>();
+            uint32_t batch_announcements = b.get<uint32_t>();
+            uint64_t batch_bytes = b.get<uint64_t>();
+
+            // snapshots are only taken right after a commit, so a batch is
+            // either all in the snapshot, or all after it
+            if (next + n <= num_run)
+            {
+                next += n;
+                continue;
+            }
+            if (next != num_run)
+                throw runtime_error("JingleNet_journal: " + journal_name + " doesn't match the snapshot");
+
+            for (uint32_t i = 0; i < n; i++)
+            {
+                apply(b);
+            }
+            next += n;
+            num_run = next;
+            count = batch_announcements;
+            bytes = batch_bytes;
+        }
+
+        if (next < num_run)
+        {
+            // the journal ends before the snapshot, so new batches can't be
+            // added to it without leaving a gap
+            start_journal(num_run);
+        }
+        else
+        {
+            filesystem::resize_file(journal_name, data.size() - in.remaining());
+            open_journal();
+        }
+    }
+
+    //
+    // Adds a command to the batch, starting at batch[start], and runs it.
+    //
+    void encode_and_apply(string_view command, string_view arg, string_view line,
+                          size_t start)
+    {
+        if (command == "SEND")
+        {
+            Announcement_fields f = parse_announcement(arg);
+            put<uint8_t>(batch, SEND);
+            put_string(batch, f.sender_name);
+            put<uint8_t>(batch, uint8_t(f.rank));
+            put_string(batch, f.text);
+        }
+        else if (command == "REMOVE_ALL")
+        {
+            put<uint8_t>(batch, REMOVE_ALL);
+            put_string(batch, arg);
+        }
+        else if (command == "PROMOTE_ANNOUNCEMENTS")
+        {
+            put<uint8_t>(batch, PROMOTE_ANNOUNCEMENTS);
+            put_string(batch, arg);
+        }
+        else if (command == "ANNOUNCE")
+        {
+            put<uint8_t>(batch, ANNOUNCE);
+            put<uint32_t>(batch, stoi(string(arg)));
+        }
+        else
+        {
+            throw runtime_error("JingleNet: unknown command \"" + string(line) + "\"");
+        }
+
+        // run the command by decoding it, exactly as recovery will
+        Byte_reader in(string_view(batch).substr(start));
+        apply(in);
+    }
+
+public:
+    //
+    // Makes a journaled JingleNet that commits every commit_every commands,
+    // and takes a snapshot every snapshot_every commands. recover must be
+    // called before any commands are run.
+    //
+    JingleNet_journal(long commit_every = 1000, long snapshot_every = 1000000)
+        : commit_every(commit_every), snapshot_every(snapshot_every),
+          batch(BATCH_HEADER_SIZE, '\0')
+    {
+    }
+
+    JingleNet_journal(const JingleNet_journal &other) = delete;
+    JingleNet_journal &operator=(const JingleNet_journal &other) = delete;
+
+    //
+    // Commits any commands still in the batch, as a best effort: a destructor
+    // must not throw (it may be running because of another exception), so an
+    // error is only printed. Call close first to find out if the last commit
+    // worked.
+    //
+    ~JingleNet_journal()
+    {
+        try
+        {
+            close();
+        }
+        catch (const exception &e)
+        {
+            cerr << "JingleNet_journal: last commit failed: " << e.what() << endl;
+        }
+    }
+
+    //
+    // Loads the latest snapshot (if any) and replays the rest of the journal
+    // (if any), and sets up announcements.txt to continue where it left off.
+    // If there is no journal, this starts a new one. Returns the number of
+    // commands already run, i.e. the number of (non-blank) commands of the
+    // input to skip.
+    //
+    long recover()
+    {
+        int count = 0;
+        long long bytes = 0;
+        jnet.set_muted(true); // the replayed announcements are already in the file
+        if (filesystem::exists(snapshot_name))
+            load_snapshot(count, bytes);
+        if (filesystem::exists(journal_name))
+            replay_journal(count, bytes);
+        else
+            start_journal(num_run);
+        jnet.set_muted(false);
+        jnet.resume(count, bytes);
+        return num_run;
+    }
+
+    //
+    // Runs one JingleNet command (see JingleNet::run), after adding it to the
+    // current batch. Blank lines are ignored.
+    //
+    void run(string_view line)
+    {
+        if (fd < 0)
+            throw runtime_error("JingleNet_journal: not open (recover hasn't been called, or close has)");
+        if (line.empty())
+            return;
+
+        size_t pos = line.find(' ');
+        string_view command = line.substr(0, pos);
+        string_view arg = pos == string_view::npos ? "" : line.substr(pos + 1);
+
+        // if the command can't be encoded or run, it's taken back out of the
+        // batch, so the batch only ever holds whole commands
+        size_t start = batch.size();
+        try
+        {
+            encode_and_apply(command, arg, line, start);
+        }
+        catch (...)
+        {
+            batch.resize(start);
+            throw;
+        }
+        batch_count++;
+        num_run++;
+
+        if (batch_count >= commit_every)
+            commit();
+        if (num_run - snapshot_at >= snapshot_every)
+            snapshot();
+    }
+
+    //
+    // Commits, and closes the journal. Throws a runtime_error if the commit
+    // fails; the journal is closed either way. Commands can't be run after
+    // this.
+    //
+    void close()
+    {
+        if (fd < 0)
+            return;
+        try
+        {
+            commit();
+        }
+        catch (...)
+        {
+            ::close(fd);
+            fd = -1;
+            throw;
+        }
+        ::close(fd);
+        fd = -1;
+    }
+
+    //
+    // Writes the current batch to the journal and waits until it's on the
+    // disk. The batch's announcements are synced first, so announcements.txt
+    // is always at least as long as the journal says.
+    //
+    void commit()
+    {
+        if (batch_count == 0)
+            return;
+        jnet.sync();
+
+        string header;
+        put<uint32_t>(header, batch_count);
+        put<uint32_t>(header, jnet.count());
+        put<uint64_t>(header, jnet.bytes_written());
+        memcpy(&batch[FRAME_HEADER_SIZE], header.data(), header.size());
+
+        string_view payload = string_view(batch).substr(FRAME_HEADER_SIZE);
+        uint32_t frame_header[2] = {uint32_t(payload.size()), checksum(payload)};
+        memcpy(&batch[0], frame_header, FRAME_HEADER_SIZE);
+
+        write_all(fd, batch);
+        sync_fd(fd);
+        batch.resize(BATCH_HEADER_SIZE);
+        batch_count = 0;
+    }
+
+    //
+    // Commits, writes a snapshot of every queued announcement, and starts a
+    // new journal.
+    //
+    void snapshot()
+    {
+        commit();
+        jnet.sync();
+
+        string payload;
+        put<uint64_t>(payload, num_run);
+        put<uint32_t>(payload, jnet.count());
+        put<uint64_t>(payload, jnet.bytes_written());
+        put<uint32_t>(payload, NUM_RANKS);
+        put<uint64_t>(payload, net.size());
+        net.for_each([&](string_view sender, Rank rank, string_view text) {
+            put_string(payload, sender);
+            put<uint8_t>(payload, uint8_t(rank));
+            put_string(payload, text);
+        });
+
+        string data(SNAPSHOT_MAGIC);
+        put_frame(data, payload);
+        replace_file(snapshot_name, data);
+        snapshot_at = num_run;
+
+        // a crash here leaves the old journal, whose commands up to
+        // snapshot_at are skipped by recovery
+        start_journal(num_run);
+    }
+
+    const JingleNet &get_net() const { return net; }
+
+    long commands_run() const { return num_run; }
+}; // class JingleNet_journal
@@ -0,0 +1,80 @@
+// JingleNet_test.cpp
+
+#include "JingleNet.h"
+#include <cassert>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+struct Test
+{
+    string name;
+    Test(const string &name)
+        : name(name)
+    {
+        cout << "Calling " << name << " ...\n";
+    }
+
+    ~Test()
+    {
+        cout << "... " << name << " done: all tests passed\n";
+    }
+}; // struct Test
+
+void test_short_lived_senders()
+{
+    Test("test_short_lived_senders");
+    JingleNet net;
+
+    // 100000 different senders, but never more than 10 with anything queued
+    for (int i = 0; i < 100000; i++)
+    {
+        net.send("user" + to_string(i), Rank(i % NUM_RANKS + 1), "hi");
+        if (i % 2 == 0)
+            net.remove_all("user" + to_string(i));
+        if (net.size() >= 10)
+            net.announce(5);
+    }
+    assert(net.num_senders() == net.size());
+    assert(net.sender_records() <= 10);
+
+    net.announce(net.size());
+    assert(net.size() == 0);
+    assert(net.num_senders() == 0);
+}
+
+void test_forgotten_sender_comes_back()
+{
+    Test("test_forgotten_sender_comes_back");
+    JingleNet net;
+    net.send("greenie", Rank::ELF1, "send candy canes");
+    net.send("bob", Rank::ELF1, "bob's first");
+    net.remove_all("greenie");
+    assert(net.num_senders() == 1);
+
+    // greenie's ID is re-used by a new sender, and greenie gets a new one
+    net.send("frosty", Rank::ELF2, "frosty's first");
+    net.send("greenie", Rank::ELF1, "back again");
+    assert(net.num_senders() == 3);
+    assert(net.sender_records() == 3);
+
+    // promoting a sender's only announcement doesn't forget them
+    net.promote_announcements("greenie");
+    net.promote_announcements("greenie");
+    net.remove_all("bob");
+
+    string all;
+    net.for_each([&](string_view sender, Rank rank, string_view text) {
+        all += string(sender) + " " + to_string(int(rank)) + " " + string(text) + "\n";
+    });
+    assert(all == "frosty 3 frosty's first\ngreenie 4 back again\n");
+}
+
+int main()
+{
+    test_short_lived_senders();
+    test_forgotten_sender_comes_back();
+
+    cout << "\nAll JingleNet tests passed!\n";
+} // main
@@ -0,0 +1,89 @@
+// Line_reader.h
+
+//
+// Reads a file one line at a time through a large buffer. Compared to calling
+// getline for every line, this reads the file in big blocks, and returns each
+// line as a string_view into the buffer so no line is copied.
+//
+
+#pragma once
+
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+class Line_reader
+{
+    ifstream infile;
+    vector<char> buf;
+    size_t start = 0; // first unread character in buf
+    size_t end = 0;   // one past the last character read into buf
+    bool at_eof = false;
+
+    //
+    // Moves the unread characters to the front of buf, and then reads as
+    // much of the file as fits after them. If a single line fills the whole
+    // buffer then the buffer is doubled in size.
+    //
+    void refill()
+    {
+        size_t unread = end - start;
+        if (start > 0)
+        {
+            memmove(buf.data(), buf.data() + start, unread);
+            start = 0;
+            end = unread;
+        }
+        if (end == buf.size())
+            buf.resize(2 * buf.size());
+
+        infile.read(buf.data() + end, buf.size() - end);
+        size_t num_read = infile.gcount();
+        end += num_read;
+        if (num_read == 0)
+            at_eof = true;
+    }
+
+public:
+    Line_reader(const string &fname, size_t buffer_size = 1 << 20)
+        : infile(fname, ios::binary), buf(buffer_size > 0 ? buffer_size : 1)
+    {
+    }
+
+    bool is_open() const { return infile.is_open(); }
+
+    //
+    // Sets line to the next line of the file, without its '\n', and returns
+    // true. Returns false if there are no more lines.
+    //
+    // line is only valid until the next call to next.
+    //
+    bool next(string_view &line)
+    {
+        while (true)
+        {
+            const char *first = buf.data() + start;
+            const char *newline = (const char *)memchr(first, '\n', end - start);
+            if (newline != nullptr)
+            {
+                line = string_view(first, newline - first);
+                start += line.size() + 1;
+                return true;
+            }
+            if (at_eof)
+            {
+                if (start == end)
+                    return false;
+                // the last line of the file doesn't end with '\n'
+                line = string_view(first, end - start);
+                start = end;
+                return true;
+            }
+            refill();
+        }
+    }
+}; // class Line_reader
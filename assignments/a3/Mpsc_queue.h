@@ -0,0 +1,98 @@
+// Mpsc_queue.h
+
+//
+// A lock-free multiple-producer single-consumer (MPSC) queue: any number of
+// threads can push at the same time, while one thread pops.
+//
+// This is Dmitry Vyukov's non-intrusive MPSC queue, see
+// https://www.1024cores.net/home/lock-free-algorithms/queues/non-intrusive-mpsc-node-based-queue
+//
+// The queue is a singly-linked list. Producers add nodes at the back with a
+// single atomic exchange, so push is wait-free. The consumer removes nodes from
+// the front, which always has a "dummy" node whose value has already been
+// popped.
+//
+// One subtlety: between a producer's exchange and its store of the next
+// pointer, the consumer can't see the new node (or any node pushed after it),
+// so pop may briefly return nothing even though a push has started. Callers
+// that need to know when to look again should have producers signal *after*
+// push returns.
+//
+
+#pragma once
+
+#include <atomic>
+#include <new>
+#include <optional>
+#include <utility>
+
+using namespace std;
+
+template <typename T>
+class Mpsc_queue
+{
+    struct Node
+    {
+        atomic<Node *> next{nullptr};
+
+        // raw storage for a T, so T doesn't need a default constructor and the
+        // dummy node doesn't hold a value
+        alignas(T) unsigned char value[sizeof(T)];
+
+        T *get() { return reinterpret_cast<T *>(value); }
+    };
+
+    atomic<Node *> back; // most recently pushed node; written by producers
+    Node *front;         // dummy node; only used by the consumer
+
+public:
+    Mpsc_queue()
+    {
+        front = new Node;
+        back.store(front);
+    }
+
+    Mpsc_queue(const Mpsc_queue &other) = delete;
+    Mpsc_queue &operator=(const Mpsc_queue &other) = delete;
+
+    //
+    // Must only be called when no other thread is using the queue.
+    //
+    ~Mpsc_queue()
+    {
+        while (pop())
+        {
+        }
+        delete front;
+    }
+
+    //
+    // Adds item to the back of the queue. Safe to call from any number of
+    // threads at the same time.
+    //
+    void push(T item)
+    {
+        Node *n = new Node;
+        new (n->value) T(std::move(item)); // "placement new" constructs in n->value
+        Node *prev = back.exchange(n, memory_order_acq_rel);
+        prev->next.store(n, memory_order_release);
+    }
+
+    //
+    // Removes and returns the item at the front of the queue, or returns an
+    // empty optional if no (completely pushed) item is available. Must only be
+    // called by the single consumer thread.
+    //
+    optional<T> pop()
+    {
+        Node *next = front->next.load(memory_order_acquire);
+        if (next == nullptr)
+            return nullopt;
+
+        optional<T> result(std::move(*next->get()));
+        next->get()->~T();
+        delete front;
+        front = next; // next is the new dummy node
+        return result;
+    }
+}; // class Mpsc_queue
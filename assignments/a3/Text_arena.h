@@ -0,0 +1,184 @@
+// Text_arena.h
+
+//
+// An arena for the text of queued announcements. Instead of each text being
+// its own string, with its own memory allocation (plus the 32-byte string
+// object), texts are copied one after the other into large chunks, and
+// referred to by a small Text_ref.
+//
+// Each chunk counts how many of its texts are still in use. When the count
+// drops to 0 the whole chunk is re-used. JingleNet announces in roughly the
+// order announcements were sent, so old chunks empty out and get re-used,
+// and the arena doesn't keep growing on long runs. (An announcement that
+// stays queued for a long time keeps its whole chunk alive, though.)
+//
+// Only MAX_SPARE_CHUNKS empty chunks keep their memory for re-use; the memory
+// of any more is given back, so after a burst of queued texts is announced
+// the arena shrinks back down.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+//
+// Where a text is stored in a Text_arena.
+//
+struct Text_ref
+{
+    uint32_t chunk;
+    uint32_t offset;
+    uint32_t size;
+};
+
+class Text_arena
+{
+    static const uint32_t CHUNK_SIZE = 1 << 16;
+    static const size_t MAX_SPARE_CHUNKS = 8;
+
+    struct Chunk
+    {
+        char *data = nullptr; // nullptr if its memory was given back
+        uint32_t cap = 0;     // CHUNK_SIZE, or bigger for one big text
+        uint32_t used = 0;
+        uint32_t live = 0; // number of texts added but not released
+    };
+
+    vector<Chunk> chunks;
+    vector<uint32_t> spare_chunks; // empty chunks that still have their memory
+    vector<uint32_t> free_chunks;  // empty chunks whose memory was given back
+    uint32_t current = 0;          // the chunk being filled
+    size_t allocated = 0;          // total bytes of chunk memory
+
+    //
+    // Returns the index of an empty chunk with capacity at least cap.
+    //
+    uint32_t new_chunk(uint32_t cap)
+    {
+        uint32_t c;
+        if (cap == CHUNK_SIZE && !spare_chunks.empty())
+        {
+            c = spare_chunks.back();
+            spare_chunks.pop_back();
+        }
+        else if (!free_chunks.empty())
+        {
+            c = free_chunks.back();
+            free_chunks.pop_back();
+        }
+        else
+        {
+            c = chunks.size();
+            chunks.emplace_back();
+        }
+
+        Chunk &ch = chunks[c];
+        if (ch.cap < cap)
+        {
+            allocated += cap - ch.cap;
+            delete[] ch.data;
+            ch.data = new char[cap];
+            ch.cap = cap;
+        }
+        ch.used = 0;
+        ch.live = 0;
+        return c;
+    }
+
+    //
+    // Makes chunk c available for re-use. A normal-sized chunk keeps its
+    // memory if there are fewer than MAX_SPARE_CHUNKS spares; otherwise, and
+    // always for a big chunk for a single text, its memory is given back.
+    //
+    void recycle(uint32_t c)
+    {
+        Chunk &ch = chunks[c];
+        if (ch.cap == CHUNK_SIZE && spare_chunks.size() < MAX_SPARE_CHUNKS)
+        {
+            spare_chunks.push_back(c);
+            return;
+        }
+        allocated -= ch.cap;
+        delete[] ch.data;
+        ch.data = nullptr;
+        ch.cap = 0;
+        free_chunks.push_back(c);
+    }
+
+public:
+    Text_arena()
+    {
+        current = new_chunk(CHUNK_SIZE);
+    }
+
+    // an arena owns its chunks, so it should not be copied
+    Text_arena(const Text_arena &other) = delete;
+    Text_arena &operator=(const Text_arena &other) = delete;
+
+    ~Text_arena()
+    {
+        for (Chunk &ch : chunks)
+        {
+            delete[] ch.data;
+        }
+    }
+
+    //
+    // Copies s into the arena, and returns where it is.
+    //
+    Text_ref add(string_view s)
+    {
+        uint32_t size = s.size();
+        uint32_t c = current;
+        if (size > CHUNK_SIZE)
+        {
+            // too big to share a chunk, so it gets its own
+            c = new_chunk(size);
+        }
+        else if (chunks[c].used + size > CHUNK_SIZE)
+        {
+            uint32_t full = current;
+            current = c = new_chunk(CHUNK_SIZE);
+            if (chunks[full].live == 0)
+                recycle(full);
+        }
+
+        Chunk &ch = chunks[c];
+        Text_ref t = {c, ch.used, size};
+        memcpy(ch.data + ch.used, s.data(), size);
+        ch.used += size;
+        ch.live++;
+        return t;
+    }
+
+    string_view get(Text_ref t) const
+    {
+        return string_view(chunks[t.chunk].data + t.offset, t.size);
+    }
+
+    //
+    // Tells the arena that the text at t is no longer needed.
+    //
+    void release(Text_ref t)
+    {
+        Chunk &ch = chunks[t.chunk];
+        ch.live--;
+        if (ch.live == 0)
+        {
+            if (t.chunk == current)
+                ch.used = 0; // start filling the current chunk from the beginning
+            else
+                recycle(t.chunk);
+        }
+    }
+
+    //
+    // Returns the total number of bytes of chunk memory the arena holds.
+    //
+    size_t bytes_allocated() const { return allocated; }
+}; // class Text_arena
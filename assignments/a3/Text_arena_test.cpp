@@ -0,0 +1,124 @@
+// Text_arena_test.cpp
+
+#include "Text_arena.h"
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+struct Test
+{
+    string name;
+    Test(const string &name)
+        : name(name)
+    {
+        cout << "Calling " << name << " ...\n";
+    }
+
+    ~Test()
+    {
+        cout << "... " << name << " done: all tests passed\n";
+    }
+}; // struct Test
+
+void test_add_get()
+{
+    Test("test_add_get");
+    Text_arena arena;
+    Text_ref a = arena.add("send candy canes");
+    Text_ref b = arena.add("");
+    Text_ref c = arena.add("I love Christmas!");
+    assert(arena.get(a) == "send candy canes");
+    assert(arena.get(b) == "");
+    assert(arena.get(c) == "I love Christmas!");
+
+    arena.release(b);
+    assert(arena.get(a) == "send candy canes");
+    assert(arena.get(c) == "I love Christmas!");
+}
+
+void test_chunks_are_reused()
+{
+    Test("test_chunks_are_reused");
+    Text_arena arena;
+
+    // a queue of 1000 texts at a time, well over one chunk's worth in total
+    vector<Text_ref> refs;
+    size_t front = 0;
+    size_t most_allocated = 0;
+    for (int i = 0; i < 100000; i++)
+    {
+        refs.push_back(arena.add("message number " + to_string(i)));
+        if (refs.size() - front > 1000)
+        {
+            assert(arena.get(refs[front]) == "message number " + to_string(front));
+            arena.release(refs[front]);
+            front++;
+        }
+        if (i == 10000)
+            most_allocated = arena.bytes_allocated();
+    }
+
+    // after the first 10000, no more memory is needed
+    assert(arena.bytes_allocated() == most_allocated);
+    for (; front < refs.size(); front++)
+    {
+        assert(arena.get(refs[front]) == "message number " + to_string(front));
+    }
+}
+
+void test_big_text()
+{
+    Test("test_big_text");
+    Text_arena arena;
+    size_t start = arena.bytes_allocated();
+    string big(1000000, 'x');
+    Text_ref small = arena.add("small");
+    Text_ref t = arena.add(big);
+    assert(arena.get(t) == big);
+    assert(arena.get(small) == "small");
+    assert(arena.bytes_allocated() >= start + big.size());
+
+    arena.release(t);
+    assert(arena.bytes_allocated() == start);
+    assert(arena.get(small) == "small");
+}
+
+void test_burst_is_given_back()
+{
+    Test("test_burst_is_given_back");
+    Text_arena arena;
+    size_t start = arena.bytes_allocated();
+
+    // about 100 chunks' worth of texts, all queued at once
+    vector<Text_ref> refs;
+    for (int i = 0; i < 300000; i++)
+    {
+        refs.push_back(arena.add("message number " + to_string(i)));
+    }
+    size_t most_allocated = arena.bytes_allocated();
+    for (Text_ref t : refs)
+    {
+        arena.release(t);
+    }
+
+    // only a few spare chunks keep their memory
+    assert(arena.bytes_allocated() < most_allocated / 10);
+
+    // and the arena still works
+    Text_ref t = arena.add("I love Christmas!");
+    assert(arena.get(t) == "I love Christmas!");
+    assert(arena.bytes_allocated() >= start);
+}
+
+int main()
+{
+    test_add_get();
+    test_chunks_are_reused();
+    test_big_text();
+    test_burst_is_given_back();
+
+    cout << "\nAll Text_arena tests passed!\n";
+} // main
@@ -24,20 +24,36 @@
 //
 /////////////////////////////////////////////////////////////////////////
 
-//
-// Do not #include any other files!
-//
-#include "Announcement.h"
-#include "JingleNet_announcer.h"
-#include "Queue_base.h"
+#include "JingleNet.h"
 #include <fstream>
 #include <iostream>
-#include <stdexcept>
 #include <string>
 
 using namespace std;
 
-int main()
+//
+// Reads JingleNet commands from the file named on the command line, one per
+// line, and runs them in order.
+//
+int main(int argc, char *argv[])
 {
-    cout << "Welcome to Assignment 3!" << endl;
-}
+    if (argc != 2)
+    {
+        cout << "Usage: " << argv[0] << " <filename>" << endl;
+        return 1;
+    }
+
+    ifstream infile(argv[1]);
+    if (!infile)
+    {
+        cout << "Error: could not open " << argv[1] << endl;
+        return 1;
+    }
+
+    JingleNet net;
+    string line;
+    while (getline(infile, line))
+    {
+        net.run(line);
+    }
+} // main
@@ -0,0 +1,144 @@
+// announcement_bench.cpp
+
+//
+// Times parsing SEND commands into Announcement objects, comparing the
+// original parser (three substr copies and a chain of to_rank comparisons)
+// with the current string_view parser.
+//
+// By default 10,000,000 command lines are parsed. To keep memory use low, a
+// set of 1000 different lines is generated and cycled through. Alternatively,
+// pass the name of a command file and its SEND lines are parsed instead.
+//
+// Compile and run like this:
+//
+//   > make announcement_bench
+//   > ./announcement_bench
+//   > ./announcement_bench jinglenet_input5.txt
+//
+
+#include "Announcement.h"
+#include <cassert>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+const int NUM_LINES = 10000000;
+const int NUM_DIFFERENT_LINES = 1000;
+
+//
+// The original to_rank from Announcement.h, for comparison.
+//
+Rank original_to_rank(const string &s)
+{
+    if (s == "snowman")
+        return Rank::SNOWMAN;
+    if (s == "elf1")
+        return Rank::ELF1;
+    if (s == "elf2")
+        return Rank::ELF2;
+    if (s == "reindeer")
+        return Rank::REINDEER;
+    if (s == "santa")
+        return Rank::SANTA;
+    assert(false);
+    return Rank::SNOWMAN;
+}
+
+//
+// The original Announcement(string line) constructor, for comparison.
+//
+Announcement original_parse(string line)
+{
+    size_t pos = line.find(' ');
+    string sender_name = line.substr(0, pos);
+    line = line.substr(pos + 1);
+
+    pos = line.find(' ');
+    Rank rank = original_to_rank(line.substr(0, pos));
+    line = line.substr(pos + 1);
+
+    return Announcement(sender_name, rank, line);
+}
+
+vector<string> make_lines()
+{
+    const string ranks[] = {"snowman", "elf1", "elf2", "reindeer", "santa"};
+    vector<string> lines;
+    for (int i = 0; i < NUM_DIFFERENT_LINES; i++)
+    {
+        lines.push_back("user" + to_string(i % 97) + " " + ranks[i % 5] +
+                        " Attention, elves! The music room is available for practice " +
+                        to_string(i));
+    }
+    return lines;
+}
+
+//
+// Returns the "SEND ..." lines from the given file, with "SEND " removed.
+//
+vector<string> read_lines(const string &fname)
+{
+    ifstream infile(fname);
+    vector<string> lines;
+    string line;
+    while (getline(infile, line))
+    {
+        if (line.rfind("SEND ", 0) == 0)
+            lines.push_back(line.substr(5));
+    }
+    return lines;
+}
+
+//
+// Parses num_lines lines (cycling through lines), and returns the CPU time in
+// seconds. The text sizes are summed so the compiler can't skip the parsing.
+//
+template <typename Parse>
+double time_parse(const vector<string> &lines, long num_lines, Parse parse, size_t &checksum)
+{
+    checksum = 0;
+    clock_t start = clock();
+    for (long i = 0; i < num_lines; i++)
+    {
+        Announcement a = parse(lines[i % lines.size()]);
+        checksum += a.get_text().size() + int(a.get_rank());
+    }
+    clock_t end = clock();
+    return double(end - start) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char *argv[])
+{
+    vector<string> lines;
+    long num_lines = NUM_LINES;
+    if (argc == 2)
+    {
+        lines = read_lines(argv[1]);
+        num_lines = lines.size();
+    }
+    else
+    {
+        lines = make_lines();
+    }
+    if (lines.empty())
+    {
+        cout << "no SEND commands to parse" << endl;
+        return 1;
+    }
+
+    size_t original_checksum = 0;
+    size_t checksum = 0;
+    double original_sec = time_parse(lines, num_lines, original_parse, original_checksum);
+    double sec = time_parse(lines, num_lines, [](const string &line)
+                            { return Announcement(line); },
+                            checksum);
+    assert(checksum == original_checksum);
+
+    cout << "Parsing " << num_lines << " SEND commands:\n"
+         << "   original parser: " << original_sec << " seconds\n"
+         << "   string_view parser: " << sec << " seconds\n";
+} // main
@@ -0,0 +1,111 @@
+// announcement_memory.cpp
+
+//
+// Measures how many bytes of memory each queued announcement uses in
+// JingleNet, compared to the previous representation where every node held a
+// full Announcement object (two strings and a rank) and a Sender pointer.
+//
+// Usage:
+//
+//   > ./announcement_memory [num_announcements] [num_senders]
+//
+// The defaults are 1000000 announcements from 1000 senders, with texts like
+// "message number 123456" (as made by jinglenet_gen).
+//
+// Heap use is measured with mallinfo2, which is specific to glibc (i.e.
+// Linux).
+//
+
+#include "JingleNet.h"
+#include <iostream>
+#include <malloc.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+//
+// Returns the number of bytes currently allocated on the heap: uordblks
+// counts normal allocations, and hblkhd counts big ones that malloc gets
+// directly from the operating system with mmap.
+//
+size_t heap_in_use()
+{
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+}
+
+//
+// The node and sender types used before sender names were interned.
+//
+struct Old_node
+{
+    Announcement announcement;
+    void *sender;
+    Old_node *prev, *next, *prev_by_sender, *next_by_sender;
+
+    Old_node(Announcement a)
+        : announcement(std::move(a)), sender(nullptr),
+          prev(nullptr), next(nullptr), prev_by_sender(nullptr), next_by_sender(nullptr)
+    {
+    }
+};
+
+struct Old_sender
+{
+    Sender_list by_rank[NUM_RANKS];
+    int count = 0;
+};
+
+string sender_name(int i, int num_senders)
+{
+    return "user" + to_string(i % num_senders + 1);
+}
+
+string text(int i)
+{
+    return "message number " + to_string(i);
+}
+
+int main(int argc, char *argv[])
+{
+    int n = argc > 1 ? stoi(argv[1]) : 1000000;
+    int num_senders = argc > 2 ? stoi(argv[2]) : 1000;
+
+    cout << n << " queued announcements from " << num_senders << " senders\n"
+         << "sizeof(Announcement) = " << sizeof(Announcement) << "\n"
+         << "sizeof(Old_node)     = " << sizeof(Old_node) << "\n"
+         << "sizeof(Node)         = " << sizeof(Node) << "\n\n";
+
+    double old_bytes;
+    {
+        size_t start = heap_in_use();
+        // the old Node_pool allocated nodes in large blocks, like a vector
+        vector<Old_node> nodes;
+        nodes.reserve(n);
+        unordered_map<string, Old_sender> senders;
+        for (int i = 0; i < n; i++)
+        {
+            string name = sender_name(i, num_senders);
+            nodes.emplace_back(Announcement(name, Rank(i % NUM_RANKS + 1), text(i)));
+            nodes.back().sender = &senders[name];
+        }
+        old_bytes = double(heap_in_use() - start) / n;
+    }
+
+    double new_bytes;
+    {
+        size_t start = heap_in_use();
+        JingleNet net;
+        for (int i = 0; i < n; i++)
+        {
+            net.send(sender_name(i, num_senders), Rank(i % NUM_RANKS + 1), text(i));
+        }
+        new_bytes = double(heap_in_use() - start) / n;
+    }
+
+    cout << "bytes per queued announcement:\n"
+         << "  Announcement in each node:     " << old_bytes << "\n"
+         << "  interned senders + text arena: " << new_bytes << "\n";
+} // main
@@ -0,0 +1,81 @@
+// jinglenet_durable.cpp
+
+//
+// Crash-safe JingleNet driver. It does the same thing as a3.cpp, but runs the
+// commands through a JingleNet_journal. If it's killed part way through,
+// running it again on the same input recovers the queued announcements and
+// announcements.txt from jinglenet.snap and jinglenet.wal, and carries on
+// from the first command that was lost. The final announcements.txt is the
+// same as if it had never been killed.
+//
+// Usage:
+//
+//   > ./jinglenet_durable <filename> [commit_every] [snapshot_every]
+//
+// commit_every (default 1000) is the number of commands per group commit,
+// and snapshot_every (default 1000000) is the number of commands between
+// snapshots. To start over instead of recovering, delete jinglenet.wal and
+// jinglenet.snap.
+//
+// For example:
+//
+//   > timeout -s KILL 1 ./jinglenet_durable big_input.txt
+//   > ./jinglenet_durable big_input.txt
+//
+
+#include "JingleNet_journal.h"
+#include "Line_reader.h"
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2 || argc > 4)
+    {
+        cout << "Usage: " << argv[0]
+             << " <filename> [commit_every] [snapshot_every]" << endl;
+        return 1;
+    }
+    long commit_every = argc > 2 ? stol(argv[2]) : 1000;
+    long snapshot_every = argc > 3 ? stol(argv[3]) : 1000000;
+
+    Line_reader reader(argv[1]);
+    if (!reader.is_open())
+    {
+        cout << "Error: could not open " << argv[1] << endl;
+        return 1;
+    }
+
+    JingleNet_journal journal(commit_every, snapshot_every);
+    auto start = chrono::steady_clock::now();
+    long skip = journal.recover();
+    auto recovered = chrono::steady_clock::now();
+    if (skip > 0)
+    {
+        cout << "recovered " << skip << " commands ("
+             << journal.get_net().size() << " announcements queued) in "
+             << chrono::duration<double>(recovered - start).count() << " seconds\n";
+    }
+
+    string_view line;
+    while (reader.next(line))
+    {
+        if (line.empty())
+            continue;
+        if (skip > 0)
+            skip--;
+        else
+            journal.run(line);
+    }
+    journal.close();
+    auto end = chrono::steady_clock::now();
+
+    double sec = chrono::duration<double>(end - recovered).count();
+    cout << journal.commands_run() << " commands run, the last ones in " << sec
+         << " seconds\n"
+         << journal.get_net().size() << " announcements still queued" << endl;
+} // main
@@ -0,0 +1,127 @@
+// jinglenet_gen.cpp
+
+//
+// Generates a random JingleNet command file, for testing and timing JingleNet
+// on large inputs. The commands are printed to cout.
+//
+// Usage:
+//
+//   > ./jinglenet_gen <num_commands> [name=value ...]
+//
+// The optional settings (with their defaults) are:
+//
+//   senders=1000          number of different sender names
+//   send=70               relative frequency of SEND commands
+//   remove=5              relative frequency of REMOVE_ALL commands
+//   promote=5             relative frequency of PROMOTE_ANNOUNCEMENTS commands
+//   announce=20           relative frequency of ANNOUNCE commands
+//   max_announce=6        ANNOUNCE n has n chosen from 1 to max_announce
+//   ranks=20,20,20,20,20  relative frequency of snowman, elf1, elf2, reindeer,
+//                         and santa announcements; if JingleNet is compiled
+//                         with more ranks, one number per rank (the default
+//                         is all equal)
+//   seed=1                random number seed; the same seed and settings
+//                         always generate the same commands
+//
+// For example:
+//
+//   > ./jinglenet_gen 1000000 senders=50 ranks=50,20,15,10,5 > input.txt
+//
+
+#include "Announcement.h"
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//
+// Parses a comma-separated list of numbers, e.g. "50,20,15,10,5".
+//
+vector<double> parse_weights(const string &s)
+{
+    vector<double> weights;
+    stringstream in(s);
+    string item;
+    while (getline(in, item, ','))
+    {
+        weights.push_back(stod(item));
+    }
+    return weights;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        cout << "Usage: " << argv[0] << " <num_commands> [name=value ...]" << endl;
+        return 1;
+    }
+    long num_commands = stol(argv[1]);
+
+    map<string, string> settings = {
+        {"senders", "1000"},
+        {"send", "70"},
+        {"remove", "5"},
+        {"promote", "5"},
+        {"announce", "20"},
+        {"max_announce", "6"},
+        {"ranks", ""},
+        {"seed", "1"},
+    };
+    for (int i = 2; i < argc; i++)
+    {
+        string arg = argv[i];
+        size_t eq = arg.find('=');
+        if (eq == string::npos || settings.count(arg.substr(0, eq)) == 0)
+        {
+            cerr << "Unknown setting: " << arg << endl;
+            return 1;
+        }
+        settings[arg.substr(0, eq)] = arg.substr(eq + 1);
+    }
+
+    vector<double> rank_weights(NUM_RANKS, 20);
+    if (settings["ranks"] != "")
+        rank_weights = parse_weights(settings["ranks"]);
+    if (rank_weights.size() != NUM_RANKS)
+    {
+        cerr << "ranks must have " << NUM_RANKS << " numbers" << endl;
+        return 1;
+    }
+
+    mt19937 rng(stoul(settings["seed"]));
+    discrete_distribution<int> command_dist({stod(settings["send"]),
+                                             stod(settings["remove"]),
+                                             stod(settings["promote"]),
+                                             stod(settings["announce"])});
+    discrete_distribution<int> rank_dist(rank_weights.begin(), rank_weights.end());
+    uniform_int_distribution<int> sender_dist(1, stoi(settings["senders"]));
+    uniform_int_distribution<int> announce_dist(1, stoi(settings["max_announce"]));
+
+    // cout is much faster when it doesn't have to stay in sync with C's stdout
+    ios::sync_with_stdio(false);
+    for (long i = 0; i < num_commands; i++)
+    {
+        string sender = "user" + to_string(sender_dist(rng));
+        switch (command_dist(rng))
+        {
+        case 0:
+            cout << "SEND " << sender << ' ' << to_string(Rank(rank_dist(rng) + 1))
+                 << " message number " << i << '\n';
+            break;
+        case 1:
+            cout << "REMOVE_ALL " << sender << '\n';
+            break;
+        case 2:
+            cout << "PROMOTE_ANNOUNCEMENTS " << sender << '\n';
+            break;
+        case 3:
+            cout << "ANNOUNCE " << announce_dist(rng) << '\n';
+            break;
+        }
+    }
+} // main
@@ -0,0 +1,69 @@
+// jinglenet_stream.cpp
+
+//
+// Streaming JingleNet driver for large command files. It does the same thing
+// as a3.cpp, but reads the command file through a Line_reader instead of
+// calling getline for every line, and reports how fast the commands ran and
+// the peak memory use of the process.
+//
+// For example:
+//
+//   > make jinglenet_gen jinglenet_stream
+//   > ./jinglenet_gen 10000000 > big_input.txt
+//   > ./jinglenet_stream big_input.txt
+//
+
+#include "JingleNet.h"
+#include "Line_reader.h"
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <sys/resource.h>
+
+using namespace std;
+
+//
+// Returns the peak resident memory used by this process so far, in KB.
+// getrusage is a Linux/Unix system call; on Linux ru_maxrss is in KB.
+//
+long peak_memory_kb()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2)
+    {
+        cout << "Usage: " << argv[0] << " <filename>" << endl;
+        return 1;
+    }
+
+    Line_reader reader(argv[1]);
+    if (!reader.is_open())
+    {
+        cout << "Error: could not open " << argv[1] << endl;
+        return 1;
+    }
+
+    JingleNet net;
+    long num_commands = 0;
+    string_view line;
+    auto start = chrono::steady_clock::now();
+    while (reader.next(line))
+    {
+        net.run(line);
+        num_commands++;
+    }
+    jnet.flush();
+    auto end = chrono::steady_clock::now();
+
+    double sec = chrono::duration<double>(end - start).count();
+    cout << num_commands << " commands in " << sec << " seconds ("
+         << long(num_commands / sec) << " commands/sec)\n"
+         << net.size() << " announcements still queued\n"
+         << "peak memory: " << peak_memory_kb() / 1024.0 << " MB" << endl;
+} // main
@@ -0,0 +1,89 @@
+// jinglenet_threads.cpp
+
+//
+// Multi-threaded JingleNet driver. The command file is read into memory, and
+// then num_senders threads submit the commands to a JingleNet_concurrent:
+// thread t submits commands t, t + num_senders, t + 2 * num_senders, ... .
+//
+// Usage:
+//
+//   > ./jinglenet_threads <filename> <num_senders> [deterministic]
+//
+// With "deterministic", announcements.txt is exactly the same as from
+// ./a3 <filename>. Without it, each thread's commands run in the order it
+// submitted them, but the commands from different threads are interleaved
+// in whatever order they arrive, so with more than one sender thread
+// announcements.txt can differ from run to run.
+//
+// For example:
+//
+//   > make a3 jinglenet_threads
+//   > ./a3 input.txt && mv announcements.txt expected.txt
+//   > ./jinglenet_threads input.txt 4 deterministic
+//   > diff announcements.txt expected.txt
+//
+
+#include "JingleNet_concurrent.h"
+#include "Line_reader.h"
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3 || argc > 4 || (argc == 4 && string(argv[3]) != "deterministic"))
+    {
+        cout << "Usage: " << argv[0] << " <filename> <num_senders> [deterministic]" << endl;
+        return 1;
+    }
+    int num_senders = stoi(argv[2]);
+    bool deterministic = argc == 4;
+
+    Line_reader reader(argv[1]);
+    if (!reader.is_open())
+    {
+        cout << "Error: could not open " << argv[1] << endl;
+        return 1;
+    }
+
+    // blank lines are skipped so that sequence numbers have no gaps
+    vector<string> commands;
+    string_view line;
+    while (reader.next(line))
+    {
+        if (!line.empty())
+            commands.emplace_back(line);
+    }
+    long num_commands = commands.size();
+
+    JingleNet_concurrent net(deterministic);
+    auto start = chrono::steady_clock::now();
+    vector<thread> senders;
+    for (int t = 0; t < num_senders; t++)
+    {
+        senders.emplace_back([&, t] {
+            for (long i = t; i < num_commands; i += num_senders)
+            {
+                net.run(commands[i], i);
+            }
+        });
+    }
+    for (thread &s : senders)
+    {
+        s.join();
+    }
+    net.finish(num_commands);
+    auto end = chrono::steady_clock::now();
+
+    double sec = chrono::duration<double>(end - start).count();
+    cout << num_commands << " commands in " << sec << " seconds ("
+         << long(num_commands / sec) << " commands/sec) using "
+         << num_senders << " sender threads"
+         << (deterministic ? " (deterministic)" : "") << "\n"
+         << net.size() << " announcements still queued" << endl;
+} // main
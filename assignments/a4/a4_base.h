@@ -43,10 +43,20 @@ struct SortStats
     size_t vector_size = 0;
     ulong num_comparisons = 0;
     double cpu_running_time_sec = 0.0;
+    ulong num_passes = 0; // for radix sorts, which don't compare values
+    ulong num_moves = 0;
+    ulong num_swaps = 0;
+
+    // Hardware counters, measured around the sort by the benchmark harness
+    // (see a4_bench.h). They are -1 if they weren't measured, e.g. because
+    // the operating system or CPU doesn't provide them.
+    long num_instructions = -1;
+    long num_cache_misses = -1;
+    long num_branch_misses = -1;
 
     string to_csv() const
     {
-        return sort_name + ", " + to_string(vector_size) + ", " + to_string(num_comparisons) + ", " + to_string(cpu_running_time_sec);
+        return sort_name + ", " + to_string(vector_size) + ", " + to_string(num_comparisons) + ", " + to_string(cpu_running_time_sec) + ", " + to_string(num_passes) + ", " + to_string(num_moves) + ", " + to_string(num_swaps) + ", " + to_string(num_instructions) + ", " + to_string(num_cache_misses) + ", " + to_string(num_branch_misses);
     }
 }; // struct SortStats
 
@@ -59,7 +69,16 @@ ostream &operator<<(ostream &os, const SortStats &ss)
        << ", size=" << ss.vector_size
        << ", num_comparisons=" << ss.num_comparisons
        << ", cpu_running_time_sec=" << ss.cpu_running_time_sec
-       << "}";
+       << ", num_passes=" << ss.num_passes
+       << ", num_moves=" << ss.num_moves
+       << ", num_swaps=" << ss.num_swaps;
+    if (ss.num_instructions >= 0)
+    {
+        os << ", num_instructions=" << ss.num_instructions
+           << ", num_cache_misses=" << ss.num_cache_misses
+           << ", num_branch_misses=" << ss.num_branch_misses;
+    }
+    os << "}";
     return os;
 }
 
@@ -98,7 +117,38 @@ template <typename T>
 SortStats iquick_sort(vector<T> &v);
 // See description in assignment.
 
+//
+// Tim sort is an adaptive merge sort: it finds and merges runs of values that
+// are already in order, so it takes O(n) time on sorted or nearly sorted
+// vectors, and O(n log n) time in the worst case.
+//
+template <typename T>
+SortStats tim_sort(vector<T> &v);
+
+//
+// Radix sorts. These sort by looking at the digits (or characters) of the
+// values instead of comparing whole values, so num_comparisons is 0 (or, for
+// strings, the number of single character comparisons), and num_passes is
+// the number of passes that distribute values into buckets.
+//
+SortStats radix_sort(vector<int> &v);
+
+SortStats radix_sort(vector<string> &v);
+
 //
 // Returns a vector of n randomly chosen ints, each <= max and >= min.
 //
 vector<int> rand_vec(int n, int min, int max);
+
+//
+// Returns a sorted vector of n randomly chosen ints, each <= max and >= min,
+// except that num_swaps randomly chosen pairs of them have been swapped.
+//
+vector<int> nearly_sorted_vec(int n, int min, int max, int num_swaps);
+
+//
+// Returns a vector of n randomly chosen ints, each <= max and >= min, where
+// the first n - tail_size are sorted and the last tail_size are not, like a
+// sorted vector with new values appended to it.
+//
+vector<int> sorted_with_tail_vec(int n, int min, int max, int tail_size);
@@ -0,0 +1,113 @@
+// a4_bench.cpp
+
+//
+// Benchmarks all the sorts in a4_sort_implementations.h, plus std::sort for
+// comparison, on ints and strings of each size and Distribution. Results are
+// printed, and written as CSV (see BENCH_CSV_HEADER in a4_bench.h) to
+// csv_file.
+//
+// Usage:
+//
+//   > ./a4_bench [max_n] [repetitions] [csv_file]
+//
+// Sizes go up by factors of 10 from 1000 to max_n (default 100000), each
+// sort is timed repetitions times (default 5) after one warmup run, and the
+// default csv_file is a4_bench.csv.
+//
+// Along with times, the comparisons, moves, and swaps each sort does are
+// reported, and on Linux the instructions, cache misses, and branch
+// mispredictions if the hardware counters are available (see Perf_counters in
+// a4_bench.h).
+//
+// The O(n^2) sorts (bubble, insertion, and selection sort) are only run on
+// sizes up to QUADRATIC_MAX_N, since otherwise they'd take hours.
+//
+
+#include "a4_base.h"
+#include "a4_sort_implementations.h"
+#include "a4_bench.h"
+#include <fstream>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+const int QUADRATIC_MAX_N = 10000;
+
+template <typename T>
+SortStats std_sort(vector<T> &v)
+{
+    clock_t start = clock();
+    sort(v.begin(), v.end());
+    return SortStats{"std::sort", v.size(), 0, cpu_seconds_since(start)};
+}
+
+//
+// Benchmarks every sort on input, and writes the results to cout and csv.
+//
+template <typename T>
+void benchmark_all(const vector<T> &input, Distribution d, int repetitions, ofstream &csv)
+{
+    typedef SortStats (*Sort)(vector<T> &);
+    vector<Sort> sorts = {merge_sort<T>, quick_sort<T>, shell_sort<T>,
+                          iquick_sort<T>, tim_sort<T>, radix_sort, std_sort<T>};
+    if (input.size() <= QUADRATIC_MAX_N)
+    {
+        sorts.insert(sorts.end(), {bubble_sort<T>, insertion_sort<T>, selection_sort<T>});
+    }
+
+    for (Sort sort : sorts)
+    {
+        Bench_result r = benchmark(sort, input, to_string(d), 1, repetitions);
+        cout << r.stats.sort_name << " on " << r.stats.vector_size << " "
+             << to_string(d) << (is_same_v<T, int> ? " ints" : " strings") << "\n"
+             << "   median " << r.wall_median_sec << " sec, min " << r.wall_min_sec
+             << " sec, stddev " << r.wall_stddev_sec << " sec (wall); median "
+             << r.stats.cpu_running_time_sec << " sec (CPU)\n"
+             << "   " << r.stats.num_comparisons << " comparisons, "
+             << r.stats.num_moves << " moves, " << r.stats.num_swaps << " swaps";
+        if (r.stats.num_instructions >= 0)
+        {
+            cout << ", " << r.stats.num_instructions << " instructions, "
+                 << r.stats.num_cache_misses << " cache misses, "
+                 << r.stats.num_branch_misses << " branch misses";
+        }
+        cout << endl;
+        csv << r.to_csv() << endl;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 4)
+    {
+        cout << "Usage: " << argv[0] << " [max_n] [repetitions] [csv_file]" << endl;
+        return 1;
+    }
+    int max_n = argc > 1 ? stoi(argv[1]) : 100000;
+    int repetitions = argc > 2 ? stoi(argv[2]) : 5;
+    string csv_file = argc > 3 ? argv[3] : "a4_bench.csv";
+
+    ofstream csv(csv_file);
+    if (!csv)
+    {
+        cout << "Error: could not open " << csv_file << endl;
+        return 1;
+    }
+    csv << BENCH_CSV_HEADER << endl;
+
+    if (!Perf_counters().available())
+    {
+        cout << "(hardware counters are not available, so they are -1 in "
+             << csv_file << ")\n";
+    }
+
+    for (int n = 1000; n <= max_n; n *= 10)
+    {
+        for (Distribution d : ALL_DISTRIBUTIONS)
+        {
+            benchmark_all(make_int_input(d, n), d, repetitions, csv);
+            benchmark_all(make_string_input(d, n), d, repetitions, csv);
+        }
+    }
+} // main
@@ -0,0 +1,438 @@
+// a4_bench.h
+
+//
+// A benchmark harness for the sorts in a4_sort_implementations.h.
+//
+// The cpu_running_time_sec in a SortStats is a single clock() measurement.
+// benchmark() instead times a sort the same way as time_runs in
+// lecture_notes/week9/sorting.cpp (see there for why): after a warmup run,
+// it reports the median, minimum, and standard deviation of several
+// steady_clock wall times, plus the median CPU time.
+//
+// Inputs come from make_int_input and make_string_input, in the distributions
+// listed in Distribution.
+//
+
+#pragma once
+
+#include "a4_base.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <ctime>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+enum class Distribution
+{
+    random,     // uniformly random values
+    sorted,     // random values, sorted
+    reversed,   // random values, sorted in reverse
+    few_unique, // only 10 different values
+    organ_pipe, // random values, ascending then descending
+    zipfian,    // a few values are very common, most are rare (like words)
+    nearly_sorted, // sorted, then 1% of the values swapped with random others
+    sorted_tail    // sorted, then 1% more random values appended
+};
+
+const vector<Distribution> ALL_DISTRIBUTIONS = {
+    Distribution::random, Distribution::sorted, Distribution::reversed,
+    Distribution::few_unique, Distribution::organ_pipe, Distribution::zipfian,
+    Distribution::nearly_sorted, Distribution::sorted_tail};
+
+string to_string(Distribution d)
+{
+    switch (d)
+    {
+    case Distribution::random:
+        return "random";
+    case Distribution::sorted:
+        return "sorted";
+    case Distribution::reversed:
+        return "reversed";
+    case Distribution::few_unique:
+        return "few_unique";
+    case Distribution::organ_pipe:
+        return "organ_pipe";
+    case Distribution::zipfian:
+        return "zipfian";
+    case Distribution::nearly_sorted:
+        return "nearly_sorted";
+    case Distribution::sorted_tail:
+        return "sorted_tail";
+    }
+    return "unknown";
+}
+
+//
+// Returns n values from 0 to num_values - 1 chosen with Zipf's law: value r is
+// chosen with probability proportional to 1 / (r + 1). In English text, word
+// frequencies roughly follow this.
+//
+vector<int> zipf_ranks(int n, int num_values, mt19937 &rng)
+{
+    vector<double> cumulative(num_values);
+    double sum = 0;
+    for (int r = 0; r < num_values; r++)
+    {
+        sum += 1.0 / (r + 1);
+        cumulative[r] = sum;
+    }
+
+    uniform_real_distribution<double> uniform(0, sum);
+    vector<int> result(n);
+    for (int i = 0; i < n; i++)
+    {
+        auto it = lower_bound(cumulative.begin(), cumulative.end(), uniform(rng));
+        result[i] = min(int(it - cumulative.begin()), num_values - 1);
+    }
+    return result;
+}
+
+//
+// Puts the values of v in the order given by d. The value distributions
+// (random, few_unique, zipfian) are left as they are.
+//
+template <typename T>
+void arrange(vector<T> &v, Distribution d, mt19937 &rng)
+{
+    if (d == Distribution::sorted)
+    {
+        sort(v.begin(), v.end());
+    }
+    else if (d == Distribution::reversed)
+    {
+        sort(v.begin(), v.end());
+        reverse(v.begin(), v.end());
+    }
+    else if (d == Distribution::organ_pipe)
+    {
+        // every other value going up, then the rest coming back down
+        sort(v.begin(), v.end());
+        vector<T> pipe;
+        pipe.reserve(v.size());
+        for (int i = 0; i < v.size(); i += 2)
+            pipe.push_back(std::move(v[i]));
+        for (int i = v.size() - 1 - v.size() % 2; i > 0; i -= 2)
+            pipe.push_back(std::move(v[i]));
+        v.swap(pipe);
+    }
+    else if (d == Distribution::nearly_sorted)
+    {
+        sort(v.begin(), v.end());
+        for (int i = 0; i < v.size() / 100; i++)
+            swap(v[rng() % v.size()], v[rng() % v.size()]);
+    }
+    else if (d == Distribution::sorted_tail)
+    {
+        sort(v.begin(), v.end() - v.size() / 100);
+    }
+}
+
+//
+// Returns n ints in the distribution d. The same seed gives the same ints.
+//
+vector<int> make_int_input(Distribution d, int n, unsigned seed = 1)
+{
+    mt19937 rng(seed);
+    vector<int> v;
+    if (d == Distribution::zipfian)
+    {
+        v = zipf_ranks(n, max(n / 10, 1), rng);
+        // so that the common values aren't all small
+        for (int &x : v)
+            x = int(x * 2654435761u);
+    }
+    else
+    {
+        uniform_int_distribution<int> uniform(-1000000000, 1000000000);
+        if (d == Distribution::few_unique)
+            uniform = uniform_int_distribution<int>(0, 9);
+        v.resize(n);
+        for (int &x : v)
+            x = uniform(rng);
+    }
+    arrange(v, d, rng);
+    return v;
+}
+
+//
+// Returns a word of lowercase letters made from x. Different x give different
+// words, in no particular order.
+//
+string make_word(unsigned x)
+{
+    x *= 2654435761u;
+    string word;
+    do
+    {
+        word += char('a' + x % 26);
+        x /= 26;
+    } while (x > 0);
+    return word;
+}
+
+//
+// Returns n strings in the distribution d. The same seed gives the same
+// strings. For zipfian, the strings are like words in English text: a few
+// are very common, most are rare.
+//
+vector<string> make_string_input(Distribution d, int n, unsigned seed = 1)
+{
+    mt19937 rng(seed);
+    vector<int> keys;
+    if (d == Distribution::zipfian)
+    {
+        keys = zipf_ranks(n, max(n / 10, 1), rng);
+    }
+    else
+    {
+        uniform_int_distribution<int> uniform(0, d == Distribution::few_unique ? 9 : 1000000000);
+        keys.resize(n);
+        for (int &k : keys)
+            k = uniform(rng);
+    }
+
+    vector<string> v;
+    v.reserve(n);
+    for (int k : keys)
+        v.push_back(make_word(k));
+    arrange(v, d, rng);
+    return v;
+}
+
+//
+// The results of benchmarking one sort on one input.
+//
+struct Bench_result
+{
+    // sort_name, vector_size, num_comparisons, and num_passes are from the
+    // sort's last run, and cpu_running_time_sec is the median CPU time
+    SortStats stats;
+    string distribution;
+    int repetitions = 0;
+    double wall_median_sec = 0.0;
+    double wall_min_sec = 0.0;
+    double wall_stddev_sec = 0.0;
+
+    //
+    // The same columns as SortStats::to_csv, followed by the extra ones in
+    // BENCH_CSV_HEADER.
+    //
+    string to_csv() const
+    {
+        return stats.to_csv() + ", " + distribution + ", " + to_string(repetitions) + ", " + to_string(wall_median_sec) + ", " + to_string(wall_min_sec) + ", " + to_string(wall_stddev_sec);
+    }
+}; // struct Bench_result
+
+const string BENCH_CSV_HEADER =
+    "sort_name, vector_size, num_comparisons, cpu_running_time_sec, num_passes, "
+    "num_moves, num_swaps, num_instructions, num_cache_misses, num_branch_misses, "
+    "distribution, repetitions, wall_median_sec, wall_min_sec, wall_stddev_sec";
+
+//
+// Hardware performance counters for instructions retired, cache misses, and
+// branch mispredictions, read with Linux's perf_event_open system call. They
+// help explain timings that comparison counts can't, e.g. why insertion sort
+// beats quick sort on small vectors: fewer mispredicted branches, and all its
+// memory accesses hit the cache.
+//
+// The counters aren't always available: other operating systems don't have
+// perf_event_open, virtual machines and containers often don't expose the
+// CPU's counters, and /proc/sys/kernel/perf_event_paranoid may forbid them.
+// Then available() is false, and read_into leaves the SortStats counters at
+// -1. They only count the calling thread, in user mode.
+//
+class Perf_counters
+{
+    static const int NUM_COUNTERS = 3;
+    int fds[NUM_COUNTERS] = {-1, -1, -1}; // fds[0] is the group leader
+
+    void close_all()
+    {
+#ifdef __linux__
+        for (int &fd : fds)
+        {
+            if (fd >= 0)
+                close(fd);
+            fd = -1;
+        }
+#endif
+    }
+
+public:
+    Perf_counters()
+    {
+#ifdef __linux__
+        const unsigned long long configs[NUM_COUNTERS] = {
+            PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES,
+            PERF_COUNT_HW_BRANCH_MISSES};
+        for (int i = 0; i < NUM_COUNTERS; i++)
+        {
+            perf_event_attr attr = {};
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = configs[i];
+            attr.disabled = i == 0; // the others follow the leader
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP;
+            fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1, fds[0], 0);
+            if (fds[i] < 0)
+            {
+                close_all();
+                return;
+            }
+        }
+#endif
+    }
+
+    // the counters are file descriptors, so they shouldn't be copied
+    Perf_counters(const Perf_counters &other) = delete;
+    Perf_counters &operator=(const Perf_counters &other) = delete;
+
+    ~Perf_counters()
+    {
+        close_all();
+    }
+
+    bool available() const { return fds[0] >= 0; }
+
+    //
+    // Sets the counters to 0 and starts counting.
+    //
+    void start()
+    {
+#ifdef __linux__
+        if (available())
+        {
+            ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+#endif
+    }
+
+    void stop()
+    {
+#ifdef __linux__
+        if (available())
+        {
+            ioctl(fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+        }
+#endif
+    }
+
+    //
+    // Copies the counts since start into stats.
+    //
+    void read_into(SortStats &stats) const
+    {
+#ifdef __linux__
+        // with PERF_FORMAT_GROUP, the number of counters, then their values
+        uint64_t values[1 + NUM_COUNTERS];
+        if (available() && read(fds[0], values, sizeof(values)) == sizeof(values))
+        {
+            stats.num_instructions = values[1];
+            stats.num_cache_misses = values[2];
+            stats.num_branch_misses = values[3];
+        }
+#else
+        (void)stats;
+#endif
+    }
+}; // class Perf_counters
+
+//
+// Returns the median of v, which must not be empty. nth_element puts the
+// middle element where it would be if v were sorted, with the smaller ones
+// before it, in O(n) time.
+//
+double median(vector<double> v)
+{
+    auto mid = v.begin() + v.size() / 2;
+    nth_element(v.begin(), mid, v.end());
+    if (v.size() % 2 == 1)
+        return *mid;
+    return (*max_element(v.begin(), mid) + *mid) / 2;
+}
+
+//
+// Returns the sample standard deviation (dividing by n - 1) of v.
+//
+double stddev(const vector<double> &v)
+{
+    if (v.size() < 2)
+        return 0.0;
+    double mean = accumulate(v.begin(), v.end(), 0.0) / v.size();
+    double sum_sq = 0;
+    for (double t : v)
+    {
+        sum_sq += (t - mean) * (t - mean);
+    }
+    return sqrt(sum_sq / (v.size() - 1));
+}
+
+//
+// Sorts a copy of input warmup + repetitions times by calling sort, which
+// returns a SortStats, and times the last repetitions runs. Copying the input
+// isn't timed. The hardware counters (if available) are from the last run.
+// Throws runtime_error if the sort doesn't sort.
+//
+template <typename T, typename Sort>
+Bench_result benchmark(Sort sort, const vector<T> &input, const string &distribution,
+                       int warmup = 1, int repetitions = 5)
+{
+    if (repetitions < 1)
+    {
+        throw runtime_error("benchmark: repetitions must be at least 1");
+    }
+
+    Bench_result result;
+    result.distribution = distribution;
+    result.repetitions = repetitions;
+    vector<double> wall_times;
+    vector<double> cpu_times;
+    Perf_counters counters;
+    for (int i = 0; i < warmup + repetitions; i++)
+    {
+        vector<T> v = input;
+
+        counters.start();
+        auto wall_start = chrono::steady_clock::now();
+        clock_t cpu_start = clock();
+        result.stats = sort(v);
+        clock_t cpu_end = clock();
+        auto wall_end = chrono::steady_clock::now();
+        counters.stop();
+        counters.read_into(result.stats);
+
+        if (!is_sorted(v))
+        {
+            throw runtime_error("benchmark: " + result.stats.sort_name + " did not sort");
+        }
+        if (i >= warmup)
+        {
+            wall_times.push_back(chrono::duration<double>(wall_end - wall_start).count());
+            cpu_times.push_back(double(cpu_end - cpu_start) / CLOCKS_PER_SEC);
+        }
+    }
+
+    result.stats.cpu_running_time_sec = median(cpu_times);
+    result.wall_median_sec = median(wall_times);
+    result.wall_min_sec = *min_element(wall_times.begin(), wall_times.end());
+    result.wall_stddev_sec = stddev(wall_times);
+    return result;
+}
@@ -27,9 +27,1291 @@
 #pragma once
 
 #include "a4_base.h"
+#include <fstream> // for reading IQUICK_CONFIG_FILE
 
 using namespace std;
 
 //
 // Put the implementations of all the functions listed in a4_base.h here.
 //
+
+//
+// Returns the number of seconds of CPU time used since start.
+//
+double cpu_seconds_since(clock_t start)
+{
+    return double(clock() - start) / CLOCKS_PER_SEC;
+}
+
+//
+// Counts of the basic steps a sort takes. All the comparisons, moves, and
+// swaps of vector values in the sorts below go through less_than,
+// take_value, and swap_values, so these count them all.
+//
+struct Sort_counts
+{
+    ulong comparisons = 0;
+    ulong moves = 0;  // values moved (or copied) from one place to another
+    ulong swaps = 0;  // pairs of values swapped; each is about 3 moves
+    ulong passes = 0; // distribution passes, for radix sorts
+};
+
+//
+// Returns a < b, and counts the comparison.
+//
+template <typename T>
+bool less_than(const T &a, const T &b, Sort_counts &counts)
+{
+    counts.comparisons++;
+    return a < b;
+}
+
+//
+// Returns from as an rvalue, so that assigning it moves it, and counts the
+// move. For example, "v[i] = take_value(v[j], counts);".
+//
+template <typename T>
+T &&take_value(T &from, Sort_counts &counts)
+{
+    counts.moves++;
+    return std::move(from);
+}
+
+//
+// Swaps a and b, and counts the swap.
+//
+template <typename T>
+void swap_values(T &a, T &b, Sort_counts &counts)
+{
+    counts.swaps++;
+    swap(a, b);
+}
+
+//
+// Returns the SortStats for a sort named sort_name of size values, which
+// started at time start and took the steps in counts.
+//
+SortStats make_stats(const string &sort_name, size_t size, const Sort_counts &counts,
+                     clock_t start)
+{
+    SortStats stats{sort_name, size, counts.comparisons, cpu_seconds_since(start)};
+    stats.num_passes = counts.passes;
+    stats.num_moves = counts.moves;
+    stats.num_swaps = counts.swaps;
+    return stats;
+}
+
+template <typename T>
+bool is_sorted(vector<T> &v)
+{
+    for (int i = 1; i < v.size(); i++)
+    {
+        if (v[i] < v[i - 1])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename T>
+SortStats bubble_sort(vector<T> &v)
+{
+    Sort_counts counts;
+    clock_t start = clock();
+
+    int n = v.size();
+    for (int i = 0; i < n - 1; i++)
+    {
+        bool swapped = false;
+        for (int j = 0; j < n - 1 - i; j++)
+        {
+            if (less_than(v[j + 1], v[j], counts))
+            {
+                swap_values(v[j], v[j + 1], counts);
+                swapped = true;
+            }
+        }
+        if (!swapped)
+        {
+            break;
+        }
+    }
+
+    return make_stats("Bubble sort", v.size(), counts, start);
+}
+
+//
+// Insertion sorts v[begin..end-1]. Used by insertion_sort, and by the quick
+// sorts to finish off small sub-vectors.
+//
+template <typename T>
+void insertion_sort(vector<T> &v, int begin, int end, Sort_counts &counts)
+{
+    for (int i = begin + 1; i < end; i++)
+    {
+        T x = take_value(v[i], counts);
+        int j = i;
+        while (j > begin && less_than(x, v[j - 1], counts))
+        {
+            v[j] = take_value(v[j - 1], counts);
+            j--;
+        }
+        v[j] = take_value(x, counts);
+    }
+}
+
+template <typename T>
+SortStats insertion_sort(vector<T> &v)
+{
+    Sort_counts counts;
+    clock_t start = clock();
+
+    insertion_sort(v, 0, v.size(), counts);
+
+    return make_stats("Insertion sort", v.size(), counts, start);
+}
+
+template <typename T>
+SortStats selection_sort(vector<T> &v)
+{
+    Sort_counts counts;
+    clock_t start = clock();
+
+    int n = v.size();
+    for (int i = 0; i < n - 1; i++)
+    {
+        int min_index = i;
+        for (int j = i + 1; j < n; j++)
+        {
+            if (less_than(v[j], v[min_index], counts))
+            {
+                min_index = j;
+            }
+        }
+        if (min_index != i)
+        {
+            swap_values(v[i], v[min_index], counts);
+        }
+    }
+
+    return make_stats("Selection sort", v.size(), counts, start);
+}
+
+//
+// Merges the sorted ranges v[begin..mid-1] and v[mid..end-1] using tmp as
+// scratch space. Taking from the left range on ties keeps the sort stable.
+//
+template <typename T>
+void merge(vector<T> &v, vector<T> &tmp, int begin, int mid, int end, Sort_counts &counts)
+{
+    int i = begin;
+    int j = mid;
+    int k = begin;
+    while (i < mid && j < end)
+    {
+        if (less_than(v[j], v[i], counts))
+            tmp[k++] = take_value(v[j++], counts);
+        else
+            tmp[k++] = take_value(v[i++], counts);
+    }
+    while (i < mid)
+        tmp[k++] = take_value(v[i++], counts);
+    while (j < end)
+        tmp[k++] = take_value(v[j++], counts);
+    for (k = begin; k < end; k++)
+        v[k] = take_value(tmp[k], counts);
+}
+
+template <typename T>
+void merge_sort(vector<T> &v, vector<T> &tmp, int begin, int end, Sort_counts &counts)
+{
+    if (end - begin < 2)
+        return;
+    int mid = begin + (end - begin) / 2;
+    merge_sort(v, tmp, begin, mid, counts);
+    merge_sort(v, tmp, mid, end, counts);
+    merge(v, tmp, begin, mid, end, counts);
+}
+
+template <typename T>
+SortStats merge_sort(vector<T> &v)
+{
+    Sort_counts counts;
+    clock_t start = clock();
+
+    // one scratch vector for all the merges
+    vector<T> tmp(v.size());
+    merge_sort(v, tmp, 0, v.size(), counts);
+
+    return make_stats("Merge sort", v.size(), counts, start);
+}
+
+//
+// Quick sort
+// ----------
+//
+// The textbook quick sort takes O(n^2) time on some inputs: sorted or reverse
+// sorted input if the pivot is badly chosen, inputs with lots of equal values
+// if equal values all go to one side, and "median-of-3 killer" inputs crafted
+// against whatever pivot rule is used. Its recursion can also get O(n) deep,
+// and overflow the stack.
+//
+// The quick sort here is hardened against all of these, in the same way as
+// introsort (the algorithm most std::sort implementations use):
+//
+// - The pivot is the median of 3 values (first, middle, last), or for bigger
+//   sub-vectors the median of 3 medians-of-3 spread out across it (Tukey's
+//   "ninther"). Sorted and reverse sorted inputs get perfect pivots.
+//
+// - Partitioning is 3-way (Dijkstra's "Dutch national flag"), into values less
+//   than, equal to, and greater than the pivot. The equal values are never
+//   looked at again, so a vector of all-equal values takes just one pass.
+//
+// - It recurses on the smaller side and loops on the bigger side, so the
+//   recursion is at most about log2(n) deep.
+//
+// - If the partitions stay lopsided for more than 2*floor(log2(n)) levels, the
+//   pivots must be bad, and that sub-vector is heap sorted instead. This
+//   guarantees O(n log n) time on every input.
+//
+// - Sub-vectors with no more than cutoff values are insertion sorted. For
+//   quick_sort the cutoff is 1 (so no insertion sort), and for iquick_sort
+//   it's iquick_cutoff<T>().
+//
+
+// sub-vectors at least this big use a ninther pivot
+const int NINTHER_THRESHOLD = 40;
+
+// sub-vectors this size or less are insertion sorted by iquick_sort, unless
+// IQUICK_CONFIG_FILE says otherwise
+const int IQUICK_SORT_CUTOFF = 16;
+
+//
+// The best cutoff depends on the computer (e.g. its cache sizes and how
+// costly a mispredicted branch is) and on the type being sorted (comparing
+// strings costs more than comparing ints). a4_tune times iquick_sort with
+// different cutoffs on this computer, and saves the best one for each type
+// in IQUICK_CONFIG_FILE. Each line of it is a type name and a cutoff, e.g.:
+//
+//   int 24
+//   string 12
+//
+const string IQUICK_CONFIG_FILE = "iquick_cutoff.txt";
+
+//
+// The name of type T in IQUICK_CONFIG_FILE. Types without a name always use
+// IQUICK_SORT_CUTOFF.
+//
+template <typename T>
+string iquick_type_name()
+{
+    return "";
+}
+
+template <>
+string iquick_type_name<int>()
+{
+    return "int";
+}
+
+template <>
+string iquick_type_name<string>()
+{
+    return "string";
+}
+
+//
+// Returns the cutoff for type_name in IQUICK_CONFIG_FILE, or
+// IQUICK_SORT_CUTOFF if there isn't one.
+//
+int load_iquick_cutoff(const string &type_name)
+{
+    ifstream config(IQUICK_CONFIG_FILE);
+    string name;
+    int cutoff;
+    while (config >> name >> cutoff)
+    {
+        if (name == type_name && cutoff >= 1)
+        {
+            return cutoff;
+        }
+    }
+    return IQUICK_SORT_CUTOFF;
+}
+
+//
+// Returns iquick_sort's cutoff for type T. IQUICK_CONFIG_FILE is only read
+// the first time.
+//
+template <typename T>
+int iquick_cutoff()
+{
+    static const int cutoff = load_iquick_cutoff(iquick_type_name<T>());
+    return cutoff;
+}
+
+//
+// Returns the index of the median of v[a], v[b], and v[c].
+//
+template <typename T>
+int median_of_3(const vector<T> &v, int a, int b, int c, Sort_counts &counts)
+{
+    if (less_than(v[a], v[b], counts))
+    {
+        if (less_than(v[b], v[c], counts))
+            return b;
+        return less_than(v[a], v[c], counts) ? c : a;
+    }
+    else
+    {
+        if (less_than(v[a], v[c], counts))
+            return a;
+        return less_than(v[b], v[c], counts) ? c : b;
+    }
+}
+
+//
+// Returns the index of the pivot for v[begin..end-1].
+//
+template <typename T>
+int choose_pivot(const vector<T> &v, int begin, int end, Sort_counts &counts)
+{
+    int n = end - begin;
+    int mid = begin + n / 2;
+    if (n < NINTHER_THRESHOLD)
+        return median_of_3(v, begin, mid, end - 1, counts);
+
+    int step = n / 8;
+    int a = median_of_3(v, begin, begin + step, begin + 2 * step, counts);
+    int b = median_of_3(v, mid - step, mid, mid + step, counts);
+    int c = median_of_3(v, end - 1 - 2 * step, end - 1 - step, end - 1, counts);
+    return median_of_3(v, a, b, c, counts);
+}
+
+//
+// Moves v[i] down the max-heap stored in v[begin..begin+n-1] to where it
+// belongs. i is relative to begin.
+//
+template <typename T>
+void sift_down(vector<T> &v, int begin, int i, int n, Sort_counts &counts)
+{
+    T x = take_value(v[begin + i], counts);
+    while (2 * i + 1 < n)
+    {
+        int child = 2 * i + 1;
+        if (child + 1 < n && less_than(v[begin + child], v[begin + child + 1], counts))
+            child++;
+        if (!less_than(x, v[begin + child], counts))
+            break;
+        v[begin + i] = take_value(v[begin + child], counts);
+        i = child;
+    }
+    v[begin + i] = take_value(x, counts);
+}
+
+//
+// Heap sorts v[begin..end-1]. This is quick sort's fallback when its pivots
+// keep being bad.
+//
+template <typename T>
+void heap_sort(vector<T> &v, int begin, int end, Sort_counts &counts)
+{
+    int n = end - begin;
+    for (int i = n / 2 - 1; i >= 0; i--)
+    {
+        sift_down(v, begin, i, n, counts);
+    }
+    for (int last = n - 1; last > 0; last--)
+    {
+        swap_values(v[begin], v[begin + last], counts);
+        sift_down(v, begin, 0, last, counts);
+    }
+}
+
+//
+// Returns floor(log2(n)), for n >= 1.
+//
+int floor_log2(int n)
+{
+    int result = 0;
+    while (n > 1)
+    {
+        n /= 2;
+        result++;
+    }
+    return result;
+}
+
+//
+// Sorts v[begin..end-1] as described above. depth_limit is how many more
+// levels of partitioning are allowed before switching to heap sort.
+//
+template <typename T>
+void quick_sort(vector<T> &v, int begin, int end, int depth_limit, int cutoff,
+                Sort_counts &counts)
+{
+    while (end - begin > cutoff)
+    {
+        if (depth_limit == 0)
+        {
+            heap_sort(v, begin, end, counts);
+            return;
+        }
+        depth_limit--;
+
+        // copy the pivot, since partitioning moves values around
+        T pivot = v[choose_pivot(v, begin, end, counts)];
+
+        // 3-way partition: v[begin..lt-1] < pivot, v[lt..i-1] == pivot,
+        // v[gt..end-1] > pivot, and v[i..gt-1] is not yet looked at
+        int lt = begin;
+        int i = begin;
+        int gt = end;
+        while (i < gt)
+        {
+            if (less_than(v[i], pivot, counts))
+                swap_values(v[lt++], v[i++], counts);
+            else if (less_than(pivot, v[i], counts))
+                swap_values(v[i], v[--gt], counts);
+            else
+                i++;
+        }
+
+        // recurse on the smaller side, and loop on the bigger one
+        if (lt - begin < end - gt)
+        {
+            quick_sort(v, begin, lt, depth_limit, cutoff, counts);
+            begin = gt;
+        }
+        else
+        {
+            quick_sort(v, gt, end, depth_limit, cutoff, counts);
+            end = lt;
+        }
+    }
+
+    if (cutoff > 1)
+    {
+        insertion_sort(v, begin, end, counts);
+    }
+}
+
+template <typename T>
+SortStats quick_sort(vector<T> &v)
+{
+    Sort_counts counts;
+    clock_t start = clock();
+
+    if (v.size() > 1)
+    {
+        quick_sort(v, 0, v.size(), 2 * floor_log2(v.size()), 1, counts);
+    }
+
+    return make_stats("Quick sort", v.size(), counts, start);
+}
+
+template <typename T>
+SortStats shell_sort(vector<T> &v)
+{
+    Sort_counts counts;
+    clock_t start = clock();
+
+    // Shell's original gap sequence: n/2, n/4, ..., 1
+    int n = v.size();
+    for (int gap = n / 2; gap > 0; gap /= 2)
+    {
+        // gapped insertion sort
+        for (int i = gap; i < n; i++)
+        {
+            T x = take_value(v[i], counts);
+            int j = i;
+            while (j >= gap && less_than(x, v[j - gap], counts))
+            {
+                v[j] = take_value(v[j - gap], counts);
+                j -= gap;
+            }
+            v[j] = take_value(x, counts);
+        }
+    }
+
+    return make_stats("Shell sort", v.size(), counts, start);
+}
+
+//
+// Same as iquick_sort, but with the given cutoff instead of
+// iquick_cutoff<T>(). a4_tune uses this to try different cutoffs.
+//
+template <typename T>
+SortStats iquick_sort(vector<T> &v, int cutoff)
+{
+    Sort_counts counts;
+    clock_t start = clock();
+
+    if (v.size() > 1)
+    {
+        quick_sort(v, 0, v.size(), 2 * floor_log2(v.size()), max(cutoff, 1),
+                   counts);
+    }
+
+    return make_stats("Iquick sort", v.size(), counts, start);
+}
+
+template <typename T>
+SortStats iquick_sort(vector<T> &v)
+{
+    return iquick_sort(v, iquick_cutoff<T>());
+}
+
+//
+// LSD radix sort for ints
+// -----------------------
+//
+// Sorts by the lowest RADIX_BITS bits first, then the next RADIX_BITS bits,
+// and so on, with a stable counting sort for each digit. With 11-bit digits a
+// 32-bit int takes 3 passes, and each pass's 2048 counters fit in the L1
+// cache.
+//
+// The digits are taken from the int with its sign bit flipped, which maps
+// INT_MIN..INT_MAX in order to 0..UINT_MAX, so negative numbers come first.
+//
+// The counts for all the digits are made in one pass at the start, and a
+// digit that's the same in every value (e.g. the top digit of small positive
+// numbers) is skipped. Each pass moves the values between v and a single
+// scratch vector.
+//
+const int RADIX_BITS = 11;
+const int RADIX_SIZE = 1 << RADIX_BITS;
+const int RADIX_DIGITS = (32 + RADIX_BITS - 1) / RADIX_BITS;
+
+unsigned radix_key(int x)
+{
+    return unsigned(x) ^ 0x80000000u;
+}
+
+unsigned radix_digit(unsigned key, int d)
+{
+    return (key >> (d * RADIX_BITS)) & (RADIX_SIZE - 1);
+}
+
+SortStats radix_sort(vector<int> &v)
+{
+    Sort_counts counts;
+    clock_t start = clock();
+
+    size_t n = v.size();
+    vector<size_t> count(RADIX_DIGITS * RADIX_SIZE, 0);
+    for (int x : v)
+    {
+        unsigned key = radix_key(x);
+        for (int d = 0; d < RADIX_DIGITS; d++)
+        {
+            count[d * RADIX_SIZE + radix_digit(key, d)]++;
+        }
+    }
+
+    vector<int> scratch(n);
+    for (int d = 0; d < RADIX_DIGITS && n > 0; d++)
+    {
+        size_t *c = &count[d * RADIX_SIZE];
+        if (c[radix_digit(radix_key(v[0]), d)] == n)
+        {
+            continue; // every value has the same digit d
+        }
+
+        // turn the counts into the starting index of each bucket
+        size_t sum = 0;
+        for (int i = 0; i < RADIX_SIZE; i++)
+        {
+            size_t k = c[i];
+            c[i] = sum;
+            sum += k;
+        }
+        for (int x : v)
+        {
+            scratch[c[radix_digit(radix_key(x), d)]++] = x;
+        }
+        v.swap(scratch);
+        counts.moves += n;
+        counts.passes++;
+    }
+
+    return make_stats("Radix sort", v.size(), counts, start);
+}
+
+//
+// MSD radix sort for strings
+// --------------------------
+//
+// American flag sort (McIlroy, Bostic, and McIlroy, "Engineering Radix Sort",
+// 1993): the strings are put into 257 buckets by their character at position
+// depth (bucket 0 is for strings that have no character there, since they
+// come first), and then each bucket is sorted by the next character. The
+// buckets are made in place by following cycles of swaps, so no extra
+// vector is needed.
+//
+// Buckets with fewer than MSD_CUTOFF strings aren't worth the 257 counters,
+// and are sorted with multikey quicksort instead (Bentley and Sedgewick,
+// "Fast Algorithms for Sorting and Searching Strings", 1997). It's a quick
+// sort on one character at a time: strings are partitioned 3-way on the
+// character at position depth, and the equal part goes on to the next
+// character. Tiny ranges are insertion sorted.
+//
+// Characters are compared as unsigned chars, the same as string's <.
+//
+const int MSD_CUTOFF = 64;
+const int MULTIKEY_CUTOFF = 10;
+
+//
+// Returns 0 if s has no character at position depth, and otherwise the
+// character plus 1.
+//
+int char_at(const string &s, size_t depth)
+{
+    return depth < s.size() ? (unsigned char)s[depth] + 1 : 0;
+}
+
+//
+// Insertion sorts v[begin..end-1], which all have the same first depth
+// characters.
+//
+void insertion_sort_from(vector<string> &v, int begin, int end, size_t depth,
+                         Sort_counts &counts)
+{
+    for (int i = begin + 1; i < end; i++)
+    {
+        string x = take_value(v[i], counts);
+        int j = i;
+        while (j > begin)
+        {
+            counts.comparisons++;
+            if (v[j - 1].compare(min(depth, v[j - 1].size()), string::npos,
+                                 x, min(depth, x.size()), string::npos) <= 0)
+            {
+                break;
+            }
+            v[j] = take_value(v[j - 1], counts);
+            j--;
+        }
+        v[j] = take_value(x, counts);
+    }
+}
+
+void multikey_quick_sort(vector<string> &v, int begin, int end, size_t depth,
+                         Sort_counts &counts)
+{
+    while (end - begin > MULTIKEY_CUTOFF)
+    {
+        // median of 3 characters for the pivot
+        int a = char_at(v[begin], depth);
+        int b = char_at(v[begin + (end - begin) / 2], depth);
+        int c = char_at(v[end - 1], depth);
+        counts.comparisons += 3;
+        int pivot = max(min(a, b), min(max(a, b), c));
+
+        int lt = begin;
+        int i = begin;
+        int gt = end;
+        while (i < gt)
+        {
+            int ch = char_at(v[i], depth);
+            counts.comparisons++;
+            if (ch < pivot)
+                swap_values(v[lt++], v[i++], counts);
+            else if (ch > pivot)
+                swap_values(v[i], v[--gt], counts);
+            else
+                i++;
+        }
+
+        multikey_quick_sort(v, begin, lt, depth, counts);
+        multikey_quick_sort(v, gt, end, depth, counts);
+        if (pivot == 0)
+        {
+            return; // the equal strings have all ended, so they're equal
+        }
+        begin = lt;
+        end = gt;
+        depth++;
+    }
+    insertion_sort_from(v, begin, end, depth, counts);
+}
+
+// A range of v whose strings all agree before position depth.
+struct Msd_range
+{
+    int begin;
+    int end;
+    size_t depth;
+};
+
+// The ranges still to be sorted are kept on an explicit stack rather than by
+// recursion: strings with a long common prefix would otherwise need one call
+// (and three 257-int arrays of stack) per shared character.
+void american_flag_sort(vector<string> &v, int begin, int end, size_t depth,
+                        Sort_counts &counts)
+{
+    vector<Msd_range> todo = {{begin, end, depth}};
+    while (!todo.empty())
+    {
+        Msd_range r = todo.back();
+        todo.pop_back();
+        if (r.end - r.begin < MSD_CUTOFF)
+        {
+            multikey_quick_sort(v, r.begin, r.end, r.depth, counts);
+            continue;
+        }
+        counts.passes++;
+
+        // count the bucket sizes, and find where each bucket starts and ends
+        int count[257] = {0};
+        for (int i = r.begin; i < r.end; i++)
+        {
+            count[char_at(v[i], r.depth)]++;
+        }
+
+        // all the strings share this character too, so go on to the next one
+        int b0 = char_at(v[r.begin], r.depth);
+        if (count[b0] == r.end - r.begin)
+        {
+            if (b0 != 0)
+            {
+                todo.push_back({r.begin, r.end, r.depth + 1});
+            }
+            continue;
+        }
+
+        int next[257]; // next free slot in each bucket
+        int bucket_end[257];
+        int sum = r.begin;
+        for (int b = 0; b < 257; b++)
+        {
+            next[b] = sum;
+            sum += count[b];
+            bucket_end[b] = sum;
+        }
+
+        // Move each string to its bucket: take the first string not yet in
+        // place in bucket b, swap it into the bucket it belongs in, and repeat
+        // with the string that was there until one that belongs in b turns up.
+        for (int b = 0; b < 257; b++)
+        {
+            while (next[b] < bucket_end[b])
+            {
+                int dest = char_at(v[next[b]], r.depth);
+                while (dest != b)
+                {
+                    swap_values(v[next[b]], v[next[dest]++], counts);
+                    dest = char_at(v[next[b]], r.depth);
+                }
+                next[b]++;
+            }
+        }
+
+        // bucket 0's strings have all ended, so they're equal; sort the others
+        int bucket_begin = r.begin + count[0];
+        for (int b = 1; b < 257; b++)
+        {
+            if (count[b] > 1)
+            {
+                todo.push_back({bucket_begin, bucket_begin + count[b], r.depth + 1});
+            }
+            bucket_begin += count[b];
+        }
+    }
+}
+
+SortStats radix_sort(vector<string> &v)
+{
+    Sort_counts counts;
+    clock_t start = clock();
+
+    american_flag_sort(v, 0, v.size(), 0, counts);
+
+    return make_stats("Radix sort", v.size(), counts, start);
+}
+
+//
+// Tim sort
+// --------
+//
+// An adaptive merge sort, as designed by Tim Peters for Python (see
+// listsort.txt in the CPython source). Real data often has lots of order in
+// it already, e.g. a sorted vector with a few new values appended, and Tim
+// sort takes advantage of it:
+//
+// - It scans v from left to right for "runs" that are already in order. A
+//   strictly descending run is reversed in place. Runs shorter than a minimum
+//   length (between 32 and 64) are extended with binary insertion sort.
+//
+// - Runs are kept on a stack, and merged when their lengths stop shrinking
+//   fast enough, so merges are between runs of similar lengths. This makes
+//   the worst case O(n log n), while a sorted or reverse sorted vector is one
+//   run that's found in O(n) time.
+//
+// - Before merging runs A and B, the values at the start of A that are <=
+//   B's first value, and at the end of B that are >= A's last value, are
+//   already in place and are skipped. Then only the smaller run is moved to a
+//   scratch vector.
+//
+// - When one run keeps "winning" during a merge, the merge switches to
+//   galloping: it searches for where the next value from the other run goes
+//   by checking 1, 3, 7, 15, ... values ahead and then doing a binary search,
+//   so long stretches from one run are moved without comparing each value.
+//   How many wins in a row it takes to start galloping (min_gallop) adapts
+//   to how well galloping has been paying off.
+//
+// Like merge sort, Tim sort is stable: equal values stay in the same order.
+//
+
+// galloping starts after this many wins in a row (at first)
+const int TIM_SORT_MIN_GALLOP = 7;
+
+template <typename T>
+class Tim_sorter
+{
+    vector<T> &v;
+    Sort_counts &counts;
+    vector<T> tmp;                  // scratch space for merges
+    vector<int> run_base, run_len;  // the stack of runs waiting to be merged
+    int min_gallop = TIM_SORT_MIN_GALLOP;
+
+    //
+    // Returns the minimum run length for a vector of n values. Runs shorter
+    // than this are extended with binary insertion sort. It's chosen so that
+    // n / min_run is a power of 2, or a bit less, which keeps merges balanced.
+    //
+    static int min_run_length(int n)
+    {
+        int extra = 0;
+        while (n >= 64)
+        {
+            extra |= n & 1;
+            n >>= 1;
+        }
+        return n + extra;
+    }
+
+    //
+    // Returns the length of the run starting at v[begin], making it
+    // ascending if it's strictly descending. (Equal values in a descending
+    // run would end up in the wrong order when reversed, so they end it.)
+    //
+    int count_run(int begin, int end)
+    {
+        int run_end = begin + 1;
+        if (run_end == end)
+            return 1;
+
+        if (less_than(v[run_end], v[begin], counts))
+        {
+            run_end++;
+            while (run_end < end && less_than(v[run_end], v[run_end - 1], counts))
+                run_end++;
+            for (int i = begin, j = run_end - 1; i < j; i++, j--)
+                swap_values(v[i], v[j], counts);
+        }
+        else
+        {
+            run_end++;
+            while (run_end < end && !less_than(v[run_end], v[run_end - 1], counts))
+                run_end++;
+        }
+        return run_end - begin;
+    }
+
+    //
+    // Sorts v[begin..end-1], where v[begin..sorted_end-1] is already sorted,
+    // with an insertion sort that finds where each value goes with a binary
+    // search.
+    //
+    void binary_insertion_sort(int begin, int sorted_end, int end)
+    {
+        for (int i = sorted_end; i < end; i++)
+        {
+            // find the first value bigger than v[i], so equal values stay in
+            // order
+            int lo = begin;
+            int hi = i;
+            while (lo < hi)
+            {
+                int mid = lo + (hi - lo) / 2;
+                if (less_than(v[i], v[mid], counts))
+                    hi = mid;
+                else
+                    lo = mid + 1;
+            }
+
+            T x = take_value(v[i], counts);
+            for (int j = i; j > lo; j--)
+                v[j] = take_value(v[j - 1], counts);
+            v[lo] = take_value(x, counts);
+        }
+    }
+
+    //
+    // Returns how many values in the sorted range a[base..base+len-1] are less
+    // than key, starting the search at a[base+hint]. It checks 1, 3, 7, 15, ...
+    // values away from the hint until it passes key, and then does a binary
+    // search of the last gap, so it's fast when the answer is near the hint.
+    //
+    int gallop_left(const T &key, const vector<T> &a, int base, int len, int hint)
+    {
+        // a[base + last_ofs] < key <= a[base + ofs], where -1 and len are
+        // treated as -infinity and +infinity
+        long last_ofs = 0;
+        long ofs = 1;
+        if (less_than(a[base + hint], key, counts))
+        {
+            long max_ofs = len - hint;
+            while (ofs < max_ofs && less_than(a[base + hint + ofs], key, counts))
+            {
+                last_ofs = ofs;
+                ofs = 2 * ofs + 1;
+            }
+            ofs = min(ofs, max_ofs);
+            last_ofs += hint;
+            ofs += hint;
+        }
+        else
+        {
+            long max_ofs = hint + 1;
+            while (ofs < max_ofs && !less_than(a[base + hint - ofs], key, counts))
+            {
+                last_ofs = ofs;
+                ofs = 2 * ofs + 1;
+            }
+            ofs = min(ofs, max_ofs);
+            long old_last_ofs = last_ofs;
+            last_ofs = hint - ofs;
+            ofs = hint - old_last_ofs;
+        }
+
+        last_ofs++;
+        while (last_ofs < ofs)
+        {
+            long mid = last_ofs + (ofs - last_ofs) / 2;
+            if (less_than(a[base + mid], key, counts))
+                last_ofs = mid + 1;
+            else
+                ofs = mid;
+        }
+        return ofs;
+    }
+
+    //
+    // Same as gallop_left, but returns how many values are <= key.
+    //
+    int gallop_right(const T &key, const vector<T> &a, int base, int len, int hint)
+    {
+        // a[base + last_ofs] <= key < a[base + ofs]
+        long last_ofs = 0;
+        long ofs = 1;
+        if (less_than(key, a[base + hint], counts))
+        {
+            long max_ofs = hint + 1;
+            while (ofs < max_ofs && less_than(key, a[base + hint - ofs], counts))
+            {
+                last_ofs = ofs;
+                ofs = 2 * ofs + 1;
+            }
+            ofs = min(ofs, max_ofs);
+            long old_last_ofs = last_ofs;
+            last_ofs = hint - ofs;
+            ofs = hint - old_last_ofs;
+        }
+        else
+        {
+            long max_ofs = len - hint;
+            while (ofs < max_ofs && !less_than(key, a[base + hint + ofs], counts))
+            {
+                last_ofs = ofs;
+                ofs = 2 * ofs + 1;
+            }
+            ofs = min(ofs, max_ofs);
+            last_ofs += hint;
+            ofs += hint;
+        }
+
+        last_ofs++;
+        while (last_ofs < ofs)
+        {
+            long mid = last_ofs + (ofs - last_ofs) / 2;
+            if (less_than(key, a[base + mid], counts))
+                ofs = mid;
+            else
+                last_ofs = mid + 1;
+        }
+        return ofs;
+    }
+
+    //
+    // Updates min_gallop after a round of galloping that moved n1 and n2
+    // values. If galloping isn't paying off, it's made harder to start again,
+    // and otherwise easier.
+    //
+    void update_min_gallop(int n1, int n2, int &wins1, int &wins2)
+    {
+        if (n1 < TIM_SORT_MIN_GALLOP && n2 < TIM_SORT_MIN_GALLOP)
+        {
+            min_gallop += 2;
+            wins1 = wins2 = 0; // back to one value at a time
+        }
+        else if (min_gallop > 1)
+        {
+            min_gallop--;
+        }
+    }
+
+    //
+    // Merges the runs v[base1..base1+len1-1] and v[base2..base2+len2-1], where
+    // base2 == base1 + len1 and len1 <= len2, by moving the first run to tmp
+    // and merging from left to right.
+    //
+    void merge_low(int base1, int len1, int base2, int len2)
+    {
+        tmp.resize(max(tmp.size(), size_t(len1)));
+        for (int i = 0; i < len1; i++)
+            tmp[i] = take_value(v[base1 + i], counts);
+
+        int c1 = 0;     // next value of the first run, in tmp
+        int c2 = base2; // next value of the second run, in v
+        int end2 = base2 + len2;
+        int dest = base1;
+        int wins1 = 0, wins2 = 0; // how many times in a row each run won
+        while (c1 < len1 && c2 < end2)
+        {
+            if (max(wins1, wins2) < min_gallop)
+            {
+                // one value at a time; the first run wins ties
+                if (less_than(v[c2], tmp[c1], counts))
+                {
+                    v[dest++] = take_value(v[c2++], counts);
+                    wins2++;
+                    wins1 = 0;
+                }
+                else
+                {
+                    v[dest++] = take_value(tmp[c1++], counts);
+                    wins1++;
+                    wins2 = 0;
+                }
+                continue;
+            }
+
+            // gallop: move all the first run's values <= v[c2], and then all
+            // the second run's values < tmp[c1]
+            int n1 = gallop_right(v[c2], tmp, c1, len1 - c1, 0);
+            for (int i = 0; i < n1; i++)
+                v[dest++] = take_value(tmp[c1++], counts);
+            int n2 = 0;
+            if (c1 < len1)
+            {
+                n2 = gallop_left(tmp[c1], v, c2, end2 - c2, 0);
+                for (int i = 0; i < n2; i++)
+                    v[dest++] = take_value(v[c2++], counts);
+            }
+            update_min_gallop(n1, n2, wins1, wins2);
+        }
+
+        // what's left of the second run is already in place
+        while (c1 < len1)
+            v[dest++] = take_value(tmp[c1++], counts);
+    }
+
+    //
+    // Same as merge_low, but for len1 > len2: the second run is moved to tmp,
+    // and the merge goes from right to left.
+    //
+    void merge_high(int base1, int len1, int base2, int len2)
+    {
+        tmp.resize(max(tmp.size(), size_t(len2)));
+        for (int i = 0; i < len2; i++)
+            tmp[i] = take_value(v[base2 + i], counts);
+
+        int c1 = base1 + len1 - 1; // last unmerged value of the first run, in v
+        int c2 = len2 - 1;         // last unmerged value of the second run, in tmp
+        int dest = base2 + len2 - 1;
+        int wins1 = 0, wins2 = 0;
+        while (c1 >= base1 && c2 >= 0)
+        {
+            if (max(wins1, wins2) < min_gallop)
+            {
+                // one value at a time; the second run wins ties
+                if (less_than(tmp[c2], v[c1], counts))
+                {
+                    v[dest--] = take_value(v[c1--], counts);
+                    wins1++;
+                    wins2 = 0;
+                }
+                else
+                {
+                    v[dest--] = take_value(tmp[c2--], counts);
+                    wins2++;
+                    wins1 = 0;
+                }
+                continue;
+            }
+
+            // gallop: move all the first run's values > tmp[c2], and then all
+            // the second run's values >= v[c1]
+            int len_left1 = c1 - base1 + 1;
+            int n1 = len_left1 - gallop_right(tmp[c2], v, base1, len_left1, len_left1 - 1);
+            for (int i = 0; i < n1; i++)
+                v[dest--] = take_value(v[c1--], counts);
+            int n2 = 0;
+            if (c1 >= base1)
+            {
+                n2 = c2 + 1 - gallop_left(v[c1], tmp, 0, c2 + 1, c2);
+                for (int i = 0; i < n2; i++)
+                    v[dest--] = take_value(tmp[c2--], counts);
+            }
+            update_min_gallop(n1, n2, wins1, wins2);
+        }
+
+        // what's left of the first run is already in place
+        while (c2 >= 0)
+            v[dest--] = take_value(tmp[c2--], counts);
+    }
+
+    //
+    // Merges runs i and i + 1 on the stack.
+    //
+    void merge_at(int i)
+    {
+        int base1 = run_base[i];
+        int len1 = run_len[i];
+        int base2 = run_base[i + 1];
+        int len2 = run_len[i + 1];
+        run_len[i] = len1 + len2;
+        run_base.erase(run_base.begin() + i + 1);
+        run_len.erase(run_len.begin() + i + 1);
+
+        // values at the start of run 1 that are <= run 2's first value are
+        // already in place
+        int k = gallop_right(v[base2], v, base1, len1, 0);
+        base1 += k;
+        len1 -= k;
+        if (len1 == 0)
+            return;
+
+        // so are values at the end of run 2 that are >= run 1's last value
+        len2 = gallop_left(v[base1 + len1 - 1], v, base2, len2, len2 - 1);
+        if (len2 == 0)
+            return;
+
+        if (len1 <= len2)
+            merge_low(base1, len1, base2, len2);
+        else
+            merge_high(base1, len1, base2, len2);
+    }
+
+    //
+    // Merges runs until, from the top of the stack down, each run is longer
+    // than the next one, and longer than the next two put together. Then the
+    // run lengths grow at least as fast as the Fibonacci numbers, so the stack
+    // never has more than about log(n) runs on it.
+    //
+    void merge_collapse()
+    {
+        while (run_len.size() > 1)
+        {
+            int n = run_len.size() - 2;
+            if ((n > 0 && run_len[n - 1] <= run_len[n] + run_len[n + 1]) ||
+                (n > 1 && run_len[n - 2] <= run_len[n - 1] + run_len[n]))
+            {
+                if (run_len[n - 1] < run_len[n + 1])
+                    n--;
+            }
+            else if (run_len[n] > run_len[n + 1])
+            {
+                break;
+            }
+            merge_at(n);
+        }
+    }
+
+    //
+    // Merges all the runs left on the stack.
+    //
+    void merge_force_collapse()
+    {
+        while (run_len.size() > 1)
+        {
+            int n = run_len.size() - 2;
+            if (n > 0 && run_len[n - 1] < run_len[n + 1])
+                n--;
+            merge_at(n);
+        }
+    }
+
+public:
+    Tim_sorter(vector<T> &v, Sort_counts &counts)
+        : v(v), counts(counts)
+    {
+    }
+
+    void sort()
+    {
+        int n = v.size();
+        int min_run = min_run_length(n);
+        int begin = 0;
+        while (begin < n)
+        {
+            int len = count_run(begin, n);
+            if (len < min_run)
+            {
+                int forced = min(min_run, n - begin);
+                binary_insertion_sort(begin, begin + len, begin + forced);
+                len = forced;
+            }
+            run_base.push_back(begin);
+            run_len.push_back(len);
+            merge_collapse();
+            begin += len;
+        }
+        merge_force_collapse();
+    }
+}; // class Tim_sorter
+
+template <typename T>
+SortStats tim_sort(vector<T> &v)
+{
+    Sort_counts counts;
+    clock_t start = clock();
+
+    Tim_sorter<T>(v, counts).sort();
+
+    return make_stats("Tim sort", v.size(), counts, start);
+}
+
+vector<int> rand_vec(int n, int min, int max)
+{
+    vector<int> result(n);
+    for (int i = 0; i < n; i++)
+    {
+        result[i] = min + rand() % (max - min + 1);
+    }
+    return result;
+}
+
+vector<int> nearly_sorted_vec(int n, int min, int max, int num_swaps)
+{
+    vector<int> result = rand_vec(n, min, max);
+    radix_sort(result);
+    for (int i = 0; i < num_swaps && n > 1; i++)
+    {
+        swap(result[rand() % n], result[rand() % n]);
+    }
+    return result;
+}
+
+vector<int> sorted_with_tail_vec(int n, int min, int max, int tail_size)
+{
+    tail_size = std::min(tail_size, n);
+    vector<int> result = rand_vec(n - tail_size, min, max);
+    radix_sort(result);
+    vector<int> tail = rand_vec(tail_size, min, max);
+    result.insert(result.end(), tail.begin(), tail.end());
+    return result;
+}
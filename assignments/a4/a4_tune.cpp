@@ -0,0 +1,79 @@
+// a4_tune.cpp
+
+//
+// Finds the best iquick_sort cutoff for ints and for strings on this
+// computer, and saves them in IQUICK_CONFIG_FILE, where iquick_sort reads
+// them from. Sub-vectors the cutoff size or smaller are insertion sorted
+// instead of quick sorted.
+//
+// Usage:
+//
+//   > ./a4_tune [n] [repetitions]
+//
+// Each candidate cutoff is benchmarked (see a4_bench.h) on n random values
+// (default 200000), repetitions times (default 7), and the one with the
+// smallest median wall time is chosen. Run it again on each computer the
+// sorts will run on.
+//
+
+#include "a4_base.h"
+#include "a4_sort_implementations.h"
+#include "a4_bench.h"
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+const vector<int> CANDIDATE_CUTOFFS = {1, 4, 8, 12, 16, 24, 32, 48, 64, 96, 128};
+
+//
+// Returns the cutoff in CANDIDATE_CUTOFFS that iquick sorts input fastest.
+//
+template <typename T>
+int best_cutoff(const vector<T> &input, int repetitions)
+{
+    cout << "cutoff  median wall time (sec) on " << input.size() << " "
+         << iquick_type_name<T>() << "s\n";
+    int best = IQUICK_SORT_CUTOFF;
+    double best_sec = -1;
+    for (int cutoff : CANDIDATE_CUTOFFS)
+    {
+        Bench_result r = benchmark([cutoff](vector<T> &v)
+                                   { return iquick_sort(v, cutoff); },
+                                   input, "random", 1, repetitions);
+        cout << "  " << cutoff << "\t" << r.wall_median_sec << "\n";
+        if (best_sec < 0 || r.wall_median_sec < best_sec)
+        {
+            best = cutoff;
+            best_sec = r.wall_median_sec;
+        }
+    }
+    cout << "best cutoff for " << iquick_type_name<T>() << ": " << best << "\n\n";
+    return best;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 3)
+    {
+        cout << "Usage: " << argv[0] << " [n] [repetitions]" << endl;
+        return 1;
+    }
+    int n = argc > 1 ? stoi(argv[1]) : 200000;
+    int repetitions = argc > 2 ? stoi(argv[2]) : 7;
+
+    int int_cutoff = best_cutoff(make_int_input(Distribution::random, n), repetitions);
+    int string_cutoff = best_cutoff(make_string_input(Distribution::random, n), repetitions);
+
+    ofstream config(IQUICK_CONFIG_FILE);
+    config << iquick_type_name<int>() << " " << int_cutoff << "\n"
+           << iquick_type_name<string>() << " " << string_cutoff << "\n";
+    if (!config)
+    {
+        cout << "Error: could not write " << IQUICK_CONFIG_FILE << endl;
+        return 1;
+    }
+    cout << "saved in " << IQUICK_CONFIG_FILE << endl;
+} // main
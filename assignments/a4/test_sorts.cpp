@@ -348,6 +348,12 @@ void test_iquick_sort_int()
     v = {2, 1, 0};
     iquick_sort(v);
     assert(is_sorted(v));
+    for (int cutoff : {1, 2, 16, 1000})
+    {
+        v = rand_vec(500, 0, 100);
+        iquick_sort(v, cutoff);
+        assert(is_sorted(v));
+    }
 }
 
 void test_iquick_sort_string()
@@ -373,6 +379,149 @@ void test_iquick_sort_string()
     assert(is_sorted(v));
 }
 
+void test_radix_sort_int()
+{
+    Test("test_radix_sort_int");
+    vector<int> v;
+    assert(v.size() == 0);
+    radix_sort(v);
+    assert(is_sorted(v));
+    v = {2};
+    radix_sort(v);
+    assert(is_sorted(v));
+    v = {2, 1};
+    radix_sort(v);
+    assert(is_sorted(v));
+    radix_sort(v);
+    assert(is_sorted(v));
+    v = {2, -1, 0, -2147483647 - 1, 2147483647, -5, 2048, 2047};
+    radix_sort(v);
+    assert(is_sorted(v));
+    for (int i = 0; i < 100; i++)
+    {
+        v = rand_vec(rand() % 10000, -1000000, 1000000);
+        radix_sort(v);
+        assert(is_sorted(v));
+    }
+}
+
+void test_radix_sort_string()
+{
+    Test("test_radix_sort_string");
+    vector<string> v;
+    assert(v.size() == 0);
+    radix_sort(v);
+    assert(is_sorted(v));
+    v = {"b"};
+    radix_sort(v);
+    assert(is_sorted(v));
+    v = {"b", "a"};
+    radix_sort(v);
+    assert(is_sorted(v));
+    radix_sort(v);
+    assert(is_sorted(v));
+    v = {"ab", "", "a", "abc", "b", "\xff", "ab", "", "a\x80"};
+    radix_sort(v);
+    assert(is_sorted(v));
+    for (int i = 0; i < 100; i++)
+    {
+        // lots of shared prefixes and duplicates, in buckets big and small
+        v = {};
+        for (int x : rand_vec(rand() % 10000, 0, 100000))
+        {
+            v.push_back(string(x % 3, 'a') + to_string(x % (i + 1)));
+        }
+        radix_sort(v);
+        assert(is_sorted(v));
+    }
+    // a long common prefix mustn't need a stack frame per character
+    v = {};
+    for (int x : rand_vec(100, 0, 1000))
+    {
+        v.push_back(string(10000, 'p') + to_string(x));
+    }
+    radix_sort(v);
+    assert(is_sorted(v));
+}
+
+void test_tim_sort_int()
+{
+    Test("test_tim_sort_int");
+    vector<int> v;
+    assert(v.size() == 0);
+    tim_sort(v);
+    assert(is_sorted(v));
+    v = {2};
+    tim_sort(v);
+    assert(is_sorted(v));
+    v = {2, 1};
+    tim_sort(v);
+    assert(is_sorted(v));
+    tim_sort(v);
+    assert(is_sorted(v));
+    v = {2, 1, 0};
+    tim_sort(v);
+    assert(is_sorted(v));
+    for (int i = 0; i < 100; i++)
+    {
+        int n = rand() % 10000;
+        v = rand_vec(n, 0, i);
+        tim_sort(v);
+        assert(is_sorted(v));
+        v = nearly_sorted_vec(n, 0, 1000000, i);
+        tim_sort(v);
+        assert(is_sorted(v));
+        v = sorted_with_tail_vec(n, 0, 1000000, i);
+        tim_sort(v);
+        assert(is_sorted(v));
+    }
+
+    // sorted and reverse sorted vectors are one run, so n - 1 comparisons
+    v = nearly_sorted_vec(1000, 0, 1000000, 0);
+    assert(tim_sort(v).num_comparisons == 999);
+    // (strictly decreasing: a descending run stops at equal values)
+    v = {};
+    for (int i = 1000; i > 0; i--)
+    {
+        v.push_back(i);
+    }
+    assert(tim_sort(v).num_comparisons == 999);
+    assert(is_sorted(v));
+}
+
+void test_tim_sort_string()
+{
+    Test("test_tim_sort_string");
+    vector<string> v;
+    assert(v.size() == 0);
+    tim_sort(v);
+    assert(is_sorted(v));
+    v = {"b"};
+    tim_sort(v);
+    assert(is_sorted(v));
+    v = {"b", "a"};
+    tim_sort(v);
+    assert(is_sorted(v));
+    tim_sort(v);
+    assert(is_sorted(v));
+    v = {"b", "a", "c"};
+    tim_sort(v);
+    assert(is_sorted(v));
+    v = {"a", "b", "c"};
+    tim_sort(v);
+    assert(is_sorted(v));
+    for (int i = 0; i < 20; i++)
+    {
+        v = {};
+        for (int x : sorted_with_tail_vec(rand() % 5000, 0, 1000, 50 * i))
+        {
+            v.push_back(to_string(x));
+        }
+        tim_sort(v);
+        assert(is_sorted(v));
+    }
+}
+
 int main()
 {
     test_is_sorted_int();
@@ -399,5 +548,11 @@ int main()
     test_iquick_sort_int();
     test_iquick_sort_string();
 
+    test_radix_sort_int();
+    test_radix_sort_string();
+
+    test_tim_sort_int();
+    test_tim_sort_string();
+
     cout << "\nall sorting tests passed!" << endl;
 } // main
@@ -2,11 +2,25 @@
 
 #include "test.h"
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
 #include <cstdlib>
 #include <ctime>
+#include <deque>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 using namespace std;
@@ -128,6 +142,102 @@ vector<string> get_words(const string &fname)
 
 const vector<string> TIMING_WORDS = get_words(TIMING_FILE);
 
+//
+// Timing results for a sort, from time_runs.
+//
+struct Timing
+{
+    int repetitions = 0;
+    double median_sec = 0.0; // wall time
+    double min_sec = 0.0;    // wall time
+    double stddev_sec = 0.0; // wall time
+    double median_cpu_sec = 0.0;
+    bool sorted = true;
+};
+
+double median(vector<double> v)
+{
+    std::sort(v.begin(), v.end());
+    int n = v.size();
+    return n % 2 == 1 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+}
+
+// sample standard deviation, i.e. dividing by n - 1
+double stddev(const vector<double> &v)
+{
+    int n = v.size();
+    double mean = 0;
+    for (double t : v)
+        mean += t;
+    mean /= n;
+    double sum_sq = 0;
+    for (double t : v)
+        sum_sq += (t - mean) * (t - mean);
+    return n > 1 ? sqrt(sum_sq / (n - 1)) : 0.0;
+}
+
+//
+// Sorts a copy of data repetitions times, after one untimed warmup run (if
+// repetitions > 1), and returns the median, minimum, and standard deviation
+// of the wall times, measured with steady_clock, and the median CPU time,
+// measured with clock(). Copying data isn't timed.
+//
+// A single run is noisy (other programs, cold caches, the first run paying
+// for page faults), so the median of a few is more reliable, and the minimum
+// is the least affected by noise. And CPU time adds up the time of every
+// thread (4 threads for 1 second is 4 seconds of CPU time), so for a parallel
+// sort the wall time is what matters.
+//
+template <typename T, typename Sort>
+Timing time_runs(const vector<T> &data, Sort sort, int repetitions)
+{
+    Timing result;
+    result.repetitions = repetitions;
+    vector<double> wall_times;
+    vector<double> cpu_times;
+    int warmup = repetitions > 1 ? 1 : 0;
+    for (int i = 0; i < warmup + repetitions; i++)
+    {
+        vector<T> v = data;
+        auto wall_start = chrono::steady_clock::now();
+        clock_t cpu_start = clock();
+        sort(v);
+        clock_t cpu_end = clock();
+        auto wall_end = chrono::steady_clock::now();
+
+        result.sorted = result.sorted && is_sorted(v);
+        if (i >= warmup)
+        {
+            wall_times.push_back(chrono::duration<double>(wall_end - wall_start).count());
+            cpu_times.push_back(double(cpu_end - cpu_start) / CLOCKS_PER_SEC);
+        }
+    }
+
+    result.median_sec = median(wall_times);
+    result.min_sec = *min_element(wall_times.begin(), wall_times.end());
+    result.stddev_sec = stddev(wall_times);
+    result.median_cpu_sec = median(cpu_times);
+    return result;
+}
+
+//
+// Prints t, indented under a line describing what was timed.
+//
+void print_timing(const Timing &t)
+{
+    cout << "   " << t.median_sec << " seconds";
+    if (t.repetitions > 1)
+    {
+        cout << " (median of " << t.repetitions << ", min " << t.min_sec
+             << ", stddev " << t.stddev_sec << ")";
+    }
+    cout << ", " << t.median_cpu_sec << " seconds CPU time" << endl;
+    if (!t.sorted)
+    {
+        cout << "   ERROR: not sorted" << endl;
+    }
+}
+
 struct Sort_tester
 {
     virtual ~Sort_tester() {}
@@ -141,19 +251,13 @@ struct Sort_tester
         time_sort(data);
     }
 
-    void time_sort(vector<string> data)
+    void time_sort(const vector<string> &data, int repetitions = 5)
     {
-        clock_t start = clock();
-        sort(data);
-        clock_t end = clock();
-
-        double elapsed_cpu_time_sec = double(end - start) / CLOCKS_PER_SEC;
-        cout << sort_name() << " on " << data.size() << " words from " << TIMING_FILE << "\n"
-             << "   " << elapsed_cpu_time_sec << " seconds" << endl;
-        if (!is_sorted(data))
-        {
-            cout << "   ERROR: not sorted" << endl;
-        }
+        Timing t = time_runs(data, [this](vector<string> &v)
+                             { sort(v); },
+                             repetitions);
+        cout << sort_name() << " on " << data.size() << " words from " << TIMING_FILE << endl;
+        print_timing(t);
     }
 
     void test_sort()
@@ -381,6 +485,415 @@ class Merge_sort_tester : public Sort_tester
     }
 };
 
+//
+// Work-stealing thread pool
+//
+// Starting a new thread for every parallel step is fine for a few big steps,
+// but a thread takes tens of microseconds to start. A thread pool starts its
+// threads once, and then hands them tasks.
+//
+// Each thread has its own queue of tasks. A thread adds new tasks to the back
+// of its own queue and takes them from there too, so it works on the tasks
+// it made most recently, whose data is likely still in its cache. When its
+// queue is empty it "steals" a task from the front of another thread's queue.
+// The front tasks are the oldest, which tend to be the biggest. So the work
+// spreads out by itself, with no central queue for every thread to fight
+// over, and a thread that finishes early helps the others.
+//
+// parallel_for(n, f) runs f(0), f(1), ..., f(n - 1) as tasks, and returns
+// once they're all done. The calling thread works on tasks while it waits.
+// That means a task can call parallel_for itself without deadlocking, and a
+// pool of num_threads threads only starts num_threads - 1 of them, since
+// the caller is the last one.
+//
+class Work_stealing_pool
+{
+    struct Task_queue
+    {
+        mutex m;
+        deque<function<void()>> tasks;
+    };
+
+    // queues[0] is for threads not in the pool, e.g. the one calling
+    // parallel_for; queues[i] is for workers[i - 1]
+    vector<unique_ptr<Task_queue>> queues;
+    vector<thread> workers;
+
+    mutex sleep_mutex; // workers with nothing to do sleep on wake
+    condition_variable wake;
+    atomic<int> num_queued{0}; // only increased while holding sleep_mutex
+    bool stopping = false;
+
+    // which pool and queue the current thread belongs to
+    inline static thread_local Work_stealing_pool *current_pool = nullptr;
+    inline static thread_local int current_index = 0;
+
+    int my_index() const
+    {
+        return current_pool == this ? current_index : 0;
+    }
+
+    void push(function<void()> task, int index)
+    {
+        {
+            lock_guard<mutex> lock(queues[index]->m);
+            queues[index]->tasks.push_back(std::move(task));
+        }
+        {
+            lock_guard<mutex> lock(sleep_mutex);
+            num_queued++;
+        }
+        wake.notify_one();
+    }
+
+    //
+    // Takes the newest task from queue index, or else steals the oldest task
+    // from another queue. Returns false if there are no tasks.
+    //
+    bool try_take(int index, function<void()> &task)
+    {
+        {
+            Task_queue &q = *queues[index];
+            lock_guard<mutex> lock(q.m);
+            if (!q.tasks.empty())
+            {
+                task = std::move(q.tasks.back());
+                q.tasks.pop_back();
+                num_queued--;
+                return true;
+            }
+        }
+        for (int k = 1; k < queues.size(); k++)
+        {
+            Task_queue &q = *queues[(index + k) % queues.size()];
+            lock_guard<mutex> lock(q.m);
+            if (!q.tasks.empty())
+            {
+                task = std::move(q.tasks.front());
+                q.tasks.pop_front();
+                num_queued--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void worker_loop(int index)
+    {
+        current_pool = this;
+        current_index = index;
+        function<void()> task;
+        while (true)
+        {
+            if (try_take(index, task))
+            {
+                task();
+                task = nullptr;
+                continue;
+            }
+            unique_lock<mutex> lock(sleep_mutex);
+            wake.wait(lock, [this]
+                      { return stopping || num_queued > 0; });
+            if (stopping && num_queued == 0)
+            {
+                return;
+            }
+        }
+    }
+
+public:
+    explicit Work_stealing_pool(int num_threads = thread::hardware_concurrency())
+    {
+        num_threads = max(1, num_threads);
+        for (int i = 0; i < num_threads; i++)
+        {
+            queues.push_back(make_unique<Task_queue>());
+        }
+        for (int i = 1; i < num_threads; i++)
+        {
+            workers.emplace_back([this, i]
+                                 { worker_loop(i); });
+        }
+    }
+
+    // a pool owns its threads, so it should not be copied
+    Work_stealing_pool(const Work_stealing_pool &other) = delete;
+    Work_stealing_pool &operator=(const Work_stealing_pool &other) = delete;
+
+    ~Work_stealing_pool()
+    {
+        {
+            lock_guard<mutex> lock(sleep_mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (thread &t : workers)
+        {
+            t.join();
+        }
+    }
+
+    // the number of threads that run tasks, including the caller
+    int size() const
+    {
+        return queues.size();
+    }
+
+    template <typename F>
+    void parallel_for(int n, F f)
+    {
+        atomic<int> remaining(n);
+        int index = my_index();
+        for (int i = 0; i < n; i++)
+        {
+            push([&f, &remaining, i]
+                 { f(i); remaining--; },
+                 index);
+        }
+
+        // help until all n tasks are done; the last ones may be running in
+        // other threads
+        function<void()> task;
+        while (remaining > 0)
+        {
+            if (try_take(index, task))
+            {
+                task();
+                task = nullptr;
+            }
+            else
+            {
+                this_thread::yield();
+            }
+        }
+    }
+}; // class Work_stealing_pool
+
+//
+// Returns a pool with one thread per core, shared by everything that doesn't
+// make its own pool.
+//
+Work_stealing_pool &default_pool()
+{
+    static Work_stealing_pool pool;
+    return pool;
+}
+
+//
+// Insertion sort of v[begin], v[begin + 1], ..., v[end - 1].
+//
+// O(n^2) in the worst case, but very fast on small sub-vectors, so faster
+// sorts use it for their small cases.
+//
+template <typename T>
+void insertion_sort(vector<T> &v, int begin, int end)
+{
+    for (int i = begin + 1; i < end; i++)
+    {
+        T x = std::move(v[i]);
+        int j = i;
+        while (j > begin && x < v[j - 1])
+        {
+            v[j] = std::move(v[j - 1]);
+            j--;
+        }
+        v[j] = std::move(x);
+    }
+}
+
+//
+// Merges the sorted ranges [first1, last1) and [first2, last2) into out,
+// moving (not copying) the elements. Stable: equal elements from the first
+// range come before those from the second.
+//
+template <typename It, typename Out>
+void merge_move(It first1, It last1, It first2, It last2, Out out)
+{
+    while (first1 != last1 && first2 != last2)
+    {
+        if (*first2 < *first1)
+            *out++ = std::move(*first2++);
+        else
+            *out++ = std::move(*first1++);
+    }
+    out = std::move(first1, last1, out);
+    std::move(first2, last2, out);
+}
+
+//
+// Same as merge_move, but splits the merge into pieces that are run as tasks
+// on pool, so they can be done at the same time.
+//
+// The middle element x of the longer range is moved to its final position,
+// and binary search finds where x goes in the other range. Everything to the
+// left of x in the output comes from the two left parts, so the left and
+// right parts can be merged independently.
+//
+template <typename It, typename Out>
+void parallel_merge_move(It first1, It last1, It first2, It last2, Out out,
+                         Work_stealing_pool &pool)
+{
+    const int MIN_PARALLEL_MERGE = 1 << 14;
+    if (pool.size() == 1 || (last1 - first1) + (last2 - first2) < MIN_PARALLEL_MERGE)
+    {
+        merge_move(first1, last1, first2, last2, out);
+        return;
+    }
+
+    It mid1, mid2;
+    if (last1 - first1 >= last2 - first2)
+    {
+        mid1 = first1 + (last1 - first1) / 2;
+        mid2 = lower_bound(first2, last2, *mid1); // equal elements of range 2 go after
+    }
+    else
+    {
+        mid2 = first2 + (last2 - first2) / 2;
+        mid1 = upper_bound(first1, last1, *mid2); // equal elements of range 1 go before
+    }
+    Out mid_out = out + (mid1 - first1) + (mid2 - first2);
+
+    pool.parallel_for(2, [&](int half)
+                      {
+        if (half == 0)
+            parallel_merge_move(first1, mid1, first2, mid2, out, pool);
+        else
+            parallel_merge_move(mid1, last1, mid2, last2, mid_out, pool); });
+}
+
+//
+// Merge sort with one scratch buffer
+//
+// merge_sort above allocates new vectors at every level of the recursion and
+// copies every element in and out of them. This version allocates a single
+// scratch vector the same size as v, and "ping-pongs" between the two: each
+// level of recursion merges halves from one vector into the other, so every
+// element is moved exactly once per level and nothing is copied.
+//
+// Sub-vectors of INSERTION_SORT_CUTOFF or fewer elements are sorted with
+// insertion sort, which is faster than merge sort on small inputs.
+//
+// The top levels of the recursion sort their two halves as two tasks on a
+// Work_stealing_pool, and merge them with parallel_merge_move. The pool's
+// threads are started once, so splitting doesn't start new threads, and idle
+// threads steal the halves that are still waiting.
+//
+// Performance: O(n log n) in the worst case, plus n extra space.
+//
+const int INSERTION_SORT_CUTOFF = 24;
+const int MIN_PARALLEL_SORT = 1 << 13;
+
+template <typename T>
+void merge_sort_to(vector<T> &v, vector<T> &scratch, int begin, int end,
+                   Work_stealing_pool &pool);
+
+//
+// Sorts v[begin, end), using scratch[begin, end) as temporary space.
+//
+template <typename T>
+void merge_sort_in_place(vector<T> &v, vector<T> &scratch, int begin, int end,
+                         Work_stealing_pool &pool)
+{
+    if (end - begin <= INSERTION_SORT_CUTOFF)
+    {
+        insertion_sort(v, begin, end);
+        return;
+    }
+
+    // sort each half into scratch, then merge them back into v
+    int mid = begin + (end - begin) / 2;
+    auto sort_half = [&](int half)
+    {
+        if (half == 0)
+            merge_sort_to(v, scratch, begin, mid, pool);
+        else
+            merge_sort_to(v, scratch, mid, end, pool);
+    };
+    if (pool.size() > 1 && end - begin >= MIN_PARALLEL_SORT)
+    {
+        pool.parallel_for(2, sort_half);
+    }
+    else
+    {
+        sort_half(0);
+        sort_half(1);
+    }
+    parallel_merge_move(scratch.begin() + begin, scratch.begin() + mid,
+                        scratch.begin() + mid, scratch.begin() + end,
+                        v.begin() + begin, pool);
+}
+
+//
+// Sorts v[begin, end), and moves the result into scratch[begin, end).
+//
+template <typename T>
+void merge_sort_to(vector<T> &v, vector<T> &scratch, int begin, int end,
+                   Work_stealing_pool &pool)
+{
+    if (end - begin <= INSERTION_SORT_CUTOFF)
+    {
+        insertion_sort(v, begin, end);
+        std::move(v.begin() + begin, v.begin() + end, scratch.begin() + begin);
+        return;
+    }
+
+    // sort each half in v, then merge them into scratch
+    int mid = begin + (end - begin) / 2;
+    auto sort_half = [&](int half)
+    {
+        if (half == 0)
+            merge_sort_in_place(v, scratch, begin, mid, pool);
+        else
+            merge_sort_in_place(v, scratch, mid, end, pool);
+    };
+    if (pool.size() > 1 && end - begin >= MIN_PARALLEL_SORT)
+    {
+        pool.parallel_for(2, sort_half);
+    }
+    else
+    {
+        sort_half(0);
+        sort_half(1);
+    }
+    parallel_merge_move(v.begin() + begin, v.begin() + mid,
+                        v.begin() + mid, v.begin() + end,
+                        scratch.begin() + begin, pool);
+}
+
+template <typename T>
+void merge_sort_parallel(vector<T> &v, Work_stealing_pool &pool)
+{
+    vector<T> scratch(v.size());
+    merge_sort_in_place(v, scratch, 0, v.size(), pool);
+}
+
+template <typename T>
+void merge_sort_parallel(vector<T> &v)
+{
+    merge_sort_parallel(v, default_pool());
+}
+
+class Merge_sort_parallel_tester : public Sort_tester
+{
+    Work_stealing_pool pool;
+
+public:
+    Merge_sort_parallel_tester(int num_threads = thread::hardware_concurrency())
+        : pool(num_threads)
+    {
+    }
+
+    string sort_name() const
+    {
+        return "parallel merge sort (" + to_string(pool.size()) + " threads)";
+    }
+
+    void sort(vector<string> &v)
+    {
+        merge_sort_parallel(v, pool);
+    }
+};
+
 //
 // Partitions a sub-vector of vector (for quick_sort).
 //
@@ -466,6 +979,333 @@ class Quick_sort_randomized_tester : public Sort_tester
 };
 
 
+//
+// Introsort: quick sort hardened against its bad cases
+//
+// quick_sort above has O(n^2) worst-case running time, e.g. on sorted input
+// (the last element is always the biggest), or when all the elements are equal
+// (every partition puts them all on one side). In those cases its recursion is
+// also n levels deep, which can overflow the stack. Randomizing helps with
+// sorted input, but not with equal elements.
+//
+// quick_sort_intro fixes these problems the way introsort (the algorithm
+// most std::sort implementations use) does:
+//
+// - The pivot is the median of the first, middle, and last elements, or for
+//   bigger sub-vectors the median of three such medians spread across it
+//   (Tukey's "ninther"). Sorted and reverse-sorted input get ideal pivots.
+//
+// - The partition is 3-way (Dijkstra's "Dutch national flag"): elements less
+//   than, equal to, and greater than the pivot. Elements equal to the pivot
+//   are in their final place, so all-equal input takes one pass.
+//
+// - It recurses on the smaller side and loops on the bigger one, so the
+//   recursion is at most log2(n) levels deep.
+//
+// - If partitioning goes more than 2*floor(log2(n)) levels deep, the pivots
+//   must be bad, and the sub-vector is heap sorted instead. This guarantees
+//   O(n log n) worst-case running time.
+//
+// - Sub-vectors of INSERTION_SORT_CUTOFF or fewer elements are insertion
+//   sorted.
+//
+const int NINTHER_THRESHOLD = 40;
+
+//
+// Returns the index of the median of v[a], v[b], and v[c].
+//
+template <typename T>
+int median_of_3(const vector<T> &v, int a, int b, int c)
+{
+    if (v[a] < v[b])
+    {
+        if (v[b] < v[c])
+            return b;
+        return v[a] < v[c] ? c : a;
+    }
+    if (v[a] < v[c])
+        return a;
+    return v[b] < v[c] ? c : b;
+}
+
+//
+// Returns the index of a pivot for v[begin, end).
+//
+template <typename T>
+int choose_pivot(const vector<T> &v, int begin, int end)
+{
+    int n = end - begin;
+    int mid = begin + n / 2;
+    if (n < NINTHER_THRESHOLD)
+        return median_of_3(v, begin, mid, end - 1);
+
+    int step = n / 8;
+    return median_of_3(v,
+                       median_of_3(v, begin, begin + step, begin + 2 * step),
+                       median_of_3(v, mid - step, mid, mid + step),
+                       median_of_3(v, end - 1 - 2 * step, end - 1 - step, end - 1));
+}
+
+//
+// Sorts v[begin, end). depth_limit is how many more levels of partitioning
+// are allowed before switching to heap sort.
+//
+template <typename T>
+void quick_sort_intro(vector<T> &v, int begin, int end, int depth_limit)
+{
+    while (end - begin > INSERTION_SORT_CUTOFF)
+    {
+        if (depth_limit == 0)
+        {
+            std::make_heap(v.begin() + begin, v.begin() + end);
+            std::sort_heap(v.begin() + begin, v.begin() + end);
+            return;
+        }
+        depth_limit--;
+
+        // copy the pivot, since partitioning moves elements around
+        T pivot = v[choose_pivot(v, begin, end)];
+
+        // v[begin, lt) < pivot, v[lt, i) == pivot, v[gt, end) > pivot, and
+        // v[i, gt) hasn't been looked at yet
+        int lt = begin;
+        int i = begin;
+        int gt = end;
+        while (i < gt)
+        {
+            if (v[i] < pivot)
+                swap(v[lt++], v[i++]);
+            else if (pivot < v[i])
+                swap(v[i], v[--gt]);
+            else
+                i++;
+        }
+
+        if (lt - begin < end - gt)
+        {
+            quick_sort_intro(v, begin, lt, depth_limit);
+            begin = gt;
+        }
+        else
+        {
+            quick_sort_intro(v, gt, end, depth_limit);
+            end = lt;
+        }
+    }
+    insertion_sort(v, begin, end);
+}
+
+template <typename T>
+void quick_sort_intro(vector<T> &v)
+{
+    int depth_limit = 0;
+    for (int n = v.size(); n > 1; n /= 2)
+    {
+        depth_limit += 2;
+    }
+    quick_sort_intro(v, 0, v.size(), depth_limit);
+}
+
+class Quick_sort_intro_tester : public Sort_tester
+{
+    string sort_name() const
+    {
+        return "quick sort intro";
+    }
+
+    void sort(vector<string> &v)
+    {
+        quick_sort_intro(v);
+    }
+};
+
+
+//
+// Block partitioning (BlockQuicksort)
+//
+// On random data, the "if (v[j] < pivot)" test in partition is true about half
+// the time, in no pattern, so the CPU's branch predictor guesses wrong about
+// half the time. Each wrong guess throws away about 15-20 cycles of work,
+// which is more than the comparison and swap cost.
+//
+// Block partitioning (Edelkamp and Weiss, "BlockQuicksort: Avoiding Branch
+// Mispredictions in Quicksort", 2016) separates comparing from swapping. It
+// scans a block of BLOCK_SIZE elements from each end of the range, and
+// records the offsets of the elements on the wrong side in a small buffer.
+// The loop does the same thing for every element (the comparison result is
+// added to the buffer count, instead of being branched on), so there is
+// nothing to mispredict. Then the recorded elements are swapped in a batch.
+//
+// This only pays off when comparisons are cheap and branch-free themselves,
+// so partition_by only uses it when T is an arithmetic type such as int or
+// double. For other types (like string) it does an ordinary partition, which
+// swaps only the elements that are on the wrong side.
+//
+const int BLOCK_SIZE = 64;
+
+//
+// Rearranges v[begin, end) so that the elements x where goes_left(x) is true
+// come first, and returns the index of the first element where it's false.
+//
+template <typename T, typename Pred>
+int partition_by(vector<T> &v, int begin, int end, Pred goes_left)
+{
+    int first = begin;
+    int last = end;
+
+    if constexpr (is_arithmetic_v<T>)
+    {
+        // goes_left is true for v[begin, first), and false for v[last, end)
+        unsigned char offsets_left[BLOCK_SIZE];
+        unsigned char offsets_right[BLOCK_SIZE];
+        int start_left = 0, num_left = 0;
+        int start_right = 0, num_right = 0;
+        while (last - first > 2 * BLOCK_SIZE)
+        {
+            if (num_left == 0)
+            {
+                // offsets of elements in the left block that belong on the right
+                start_left = 0;
+                for (int i = 0; i < BLOCK_SIZE; i++)
+                {
+                    offsets_left[num_left] = i;
+                    num_left += !goes_left(v[first + i]);
+                }
+            }
+            if (num_right == 0)
+            {
+                // offsets of elements in the right block that belong on the left
+                start_right = 0;
+                for (int i = 0; i < BLOCK_SIZE; i++)
+                {
+                    offsets_right[num_right] = i;
+                    num_right += goes_left(v[last - 1 - i]);
+                }
+            }
+
+            int num = min(num_left, num_right);
+            for (int k = 0; k < num; k++)
+            {
+                swap(v[first + offsets_left[start_left + k]],
+                     v[last - 1 - offsets_right[start_right + k]]);
+            }
+            num_left -= num;
+            num_right -= num;
+            start_left += num;
+            start_right += num;
+
+            // a block with no misplaced elements left is done
+            if (num_left == 0)
+                first += BLOCK_SIZE;
+            if (num_right == 0)
+                last -= BLOCK_SIZE;
+        }
+    }
+
+    if constexpr (is_arithmetic_v<T>)
+    {
+        // Partition what's left, at most 2 * BLOCK_SIZE elements. Every
+        // element is moved, and first only moves forward when the element
+        // belongs on the left, so this loop has no data-dependent branch
+        // either. Moving a number costs about as much as a comparison.
+        for (int j = first; j < last; j++)
+        {
+            T x = v[j];
+            bool left = goes_left(x);
+            v[j] = v[first];
+            v[first] = x;
+            first += left;
+        }
+    }
+    else
+    {
+        // an ordinary partition: moving a string costs far more than a
+        // mispredicted branch, so only misplaced elements are swapped
+        for (int j = first; j < last; j++)
+        {
+            if (goes_left(v[j]))
+            {
+                swap(v[first], v[j]);
+                first++;
+            }
+        }
+    }
+    return first;
+}
+
+//
+// Same as quick_sort_intro, but with a 2-way partition_by instead of the
+// 3-way partition.
+//
+// To still handle lots of equal elements, when no elements are less than the
+// pivot (i.e. the pivot is the smallest) the range is partitioned again into
+// elements equal to the pivot, which are then in their final place, and
+// elements greater than it.
+//
+template <typename T>
+void quick_sort_block(vector<T> &v, int begin, int end, int depth_limit)
+{
+    while (end - begin > INSERTION_SORT_CUTOFF)
+    {
+        if (depth_limit == 0)
+        {
+            std::make_heap(v.begin() + begin, v.begin() + end);
+            std::sort_heap(v.begin() + begin, v.begin() + end);
+            return;
+        }
+        depth_limit--;
+
+        T pivot = v[choose_pivot(v, begin, end)];
+        int mid = partition_by(v, begin, end, [&pivot](const T &x)
+                               { return x < pivot; });
+        if (mid == begin)
+        {
+            // all elements are >= pivot, so skip over the ones equal to it
+            begin = partition_by(v, begin, end, [&pivot](const T &x)
+                                 { return !(pivot < x); });
+            continue;
+        }
+
+        // both sides are non-empty, since the pivot is in the right side
+        if (mid - begin < end - mid)
+        {
+            quick_sort_block(v, begin, mid, depth_limit);
+            begin = mid;
+        }
+        else
+        {
+            quick_sort_block(v, mid, end, depth_limit);
+            end = mid;
+        }
+    }
+    insertion_sort(v, begin, end);
+}
+
+template <typename T>
+void quick_sort_block(vector<T> &v)
+{
+    int depth_limit = 0;
+    for (int n = v.size(); n > 1; n /= 2)
+    {
+        depth_limit += 2;
+    }
+    quick_sort_block(v, 0, v.size(), depth_limit);
+}
+
+class Quick_sort_block_tester : public Sort_tester
+{
+    string sort_name() const
+    {
+        return "quick sort block";
+    }
+
+    void sort(vector<string> &v)
+    {
+        quick_sort_block(v);
+    }
+};
+
+
 //
 // Quicksort using std::partition from
 // https://en.cppreference.com/w/cpp/algorithm/partition
@@ -519,6 +1359,192 @@ class Quick_sort2_tester : public Sort_tester
     }
 };
 
+//
+// Parallel sample sort
+//
+// A generalization of quick sort to p threads: instead of 1 pivot splitting
+// the input in 2, k - 1 "splitters" split it into k buckets, and then the
+// buckets are sorted independently, in parallel. It has the same iterator
+// interface as quick_sort2.
+//
+// 1. Pick the splitters. To make the buckets about the same size, take a
+//    random sample of k * OVERSAMPLING values, sort it, and use every
+//    OVERSAMPLING-th value. The more oversampling, the more even the buckets.
+//    Duplicate splitters are removed, so lots of equal values don't make
+//    empty buckets.
+//
+// 2. Classify, in parallel. The input is cut into blocks, and a task for
+//    each block finds each value's bucket with a binary search of the
+//    splitters, and counts how many of the block's values go in each bucket.
+//
+// 3. From the counts, work out where each block's values for each bucket go
+//    in a scratch vector: bucket 0's values from block 0, then from block 1,
+//    ..., then bucket 1's values from block 0, and so on. Then each block
+//    task moves its values there, without any locks, since each block has
+//    its own part of each bucket.
+//
+// 4. Sort each bucket with std::sort in its own task, and move it back. There
+//    are BUCKETS_PER_THREAD buckets per thread, so if some buckets are bigger
+//    than others, threads that finish early steal the remaining ones. A
+//    bucket much bigger than expected is sample sorted itself.
+//
+// Ranges smaller than MIN_SAMPLE_SORT aren't worth the overhead, and are
+// sorted with std::sort.
+//
+const long MIN_SAMPLE_SORT = 1 << 16;
+const int OVERSAMPLING = 32;
+const int BUCKETS_PER_THREAD = 4;
+const int BLOCKS_PER_THREAD = 4;
+const int MAX_BUCKETS = 256; // so a bucket number fits in an unsigned char
+
+template <class RandomIt>
+void sample_sort(RandomIt first, RandomIt last, Work_stealing_pool &pool, int depth = 0)
+{
+    using T = typename iterator_traits<RandomIt>::value_type;
+
+    long n = last - first;
+    int p = pool.size();
+    if (n < MIN_SAMPLE_SORT || p == 1 || depth > 1)
+    {
+        std::sort(first, last);
+        return;
+    }
+
+    // 1. pick the splitters
+    int k = min(MAX_BUCKETS, BUCKETS_PER_THREAD * p);
+    mt19937_64 rng(n);
+    uniform_int_distribution<long> random_index(0, n - 1);
+    vector<T> sample(k * OVERSAMPLING);
+    for (T &x : sample)
+    {
+        x = first[random_index(rng)];
+    }
+    std::sort(sample.begin(), sample.end());
+    vector<T> splitters;
+    for (int i = 1; i < k; i++)
+    {
+        splitters.push_back(sample[i * OVERSAMPLING]);
+    }
+    splitters.erase(unique(splitters.begin(), splitters.end()), splitters.end());
+    int num_buckets = splitters.size() + 1;
+
+    // 2. classify each block's values
+    int num_blocks = BLOCKS_PER_THREAD * p;
+    long block_size = (n + num_blocks - 1) / num_blocks;
+    vector<unsigned char> bucket_of(n);
+    vector<long> counts(num_blocks * num_buckets); // counts[block * num_buckets + bucket]
+    pool.parallel_for(num_blocks, [&](int block)
+                      {
+        long begin = block * block_size;
+        long end = min(n, begin + block_size);
+        vector<long> count(num_buckets, 0); // local, so threads don't share cache lines
+        for (long i = begin; i < end; i++)
+        {
+            int bucket = upper_bound(splitters.begin(), splitters.end(), first[i]) - splitters.begin();
+            bucket_of[i] = bucket;
+            count[bucket]++;
+        }
+        copy(count.begin(), count.end(), counts.begin() + block * num_buckets); });
+
+    // 3. turn the counts into where each block's values go, and move them
+    vector<long> bucket_start(num_buckets + 1);
+    long sum = 0;
+    for (int bucket = 0; bucket < num_buckets; bucket++)
+    {
+        bucket_start[bucket] = sum;
+        for (int block = 0; block < num_blocks; block++)
+        {
+            long count = counts[block * num_buckets + bucket];
+            counts[block * num_buckets + bucket] = sum;
+            sum += count;
+        }
+    }
+    bucket_start[num_buckets] = n;
+
+    vector<T> scratch(n);
+    pool.parallel_for(num_blocks, [&](int block)
+                      {
+        long begin = block * block_size;
+        long end = min(n, begin + block_size);
+        vector<long> next(counts.begin() + block * num_buckets,
+                          counts.begin() + (block + 1) * num_buckets);
+        for (long i = begin; i < end; i++)
+        {
+            scratch[next[bucket_of[i]]++] = std::move(first[i]);
+        } });
+
+    // 4. sort the buckets, and move them back
+    long expected_size = n / num_buckets;
+    pool.parallel_for(num_buckets, [&](int bucket)
+                      {
+        auto begin = scratch.begin() + bucket_start[bucket];
+        auto end = scratch.begin() + bucket_start[bucket + 1];
+        if (end - begin > 4 * expected_size)
+            sample_sort(begin, end, pool, depth + 1);
+        else
+            std::sort(begin, end);
+        std::move(begin, end, first + bucket_start[bucket]); });
+}
+
+template <class RandomIt>
+void sample_sort(RandomIt first, RandomIt last)
+{
+    sample_sort(first, last, default_pool());
+}
+
+class Sample_sort_tester : public Sort_tester
+{
+    Work_stealing_pool pool;
+
+public:
+    Sample_sort_tester(int num_threads = thread::hardware_concurrency())
+        : pool(num_threads)
+    {
+    }
+
+    string sort_name() const
+    {
+        return "parallel sample sort (" + to_string(pool.size()) + " threads)";
+    }
+
+    void sort(vector<string> &v)
+    {
+        sample_sort(v.begin(), v.end(), pool);
+    }
+};
+
+
+//
+// Times sort on a vector of n random ints. Sort_tester only sorts strings,
+// but some sorts (like quick_sort_block) only help ints and other
+// arithmetic types, and ints make much bigger inputs easy.
+//
+template <typename Sort>
+void time_int_sort(const string &name, int n, Sort sort)
+{
+    vector<int> v = make_rand_vector(n, 0, 1000000000);
+    Timing t = time_runs(v, sort, n < 10000000 ? 5 : 1);
+    cout << name << " on " << n << " random ints" << endl;
+    print_timing(t);
+}
+
+void time_int_sorts(int max_n)
+{
+    for (int n = 100000; n <= max_n; n *= 10)
+    {
+        time_int_sort("quick sort", n, [](vector<int> &v)
+                      { quick_sort(v); });
+        time_int_sort("quick sort intro", n, [](vector<int> &v)
+                      { quick_sort_intro(v); });
+        time_int_sort("quick sort block", n, [](vector<int> &v)
+                      { quick_sort_block(v); });
+        time_int_sort("std::sort", n, [](vector<int> &v)
+                      { std::sort(v.begin(), v.end()); });
+        time_int_sort("parallel sample sort", n, [](vector<int> &v)
+                      { sample_sort(v.begin(), v.end()); });
+    }
+}
+
 
 class Std_sort_tester : public Sort_tester
 {
@@ -534,6 +1560,183 @@ class Std_sort_tester : public Sort_tester
 };
 
 
+//
+// Indirect sort
+//
+// Sorting strings directly is slower than it looks. Every comparison follows
+// two pointers to the strings' characters, which are scattered around the
+// heap, so most comparisons are cache misses. And each string moved is a
+// 32-byte object.
+//
+// indirect_sort instead sorts a vector of small (key, index) pairs, one per
+// string. The key is the string's first 8 characters packed into a 64-bit
+// integer, most significant byte first, so comparing two keys as integers
+// gives the same answer as comparing the strings' first 8 characters. Only
+// when two keys are equal, and both strings are longer than 8 characters,
+// does it have to look at the strings themselves. When the sort is done, the
+// indexes say where each string goes, and the strings are moved there in one
+// pass.
+//
+// This works best when most strings differ in their first 8 characters. If
+// lots of strings share a longer prefix (e.g. URLs that all start with
+// "https://www."), nearly every comparison is a tie, and it's slower than
+// sorting the strings directly.
+//
+
+//
+// Returns the first 8 characters of s as a 64-bit integer, with s[0] in the
+// most significant byte. Strings shorter than 8 characters are padded with 0
+// bytes.
+//
+uint64_t prefix_key(const string &s)
+{
+    uint64_t key = 0;
+    for (int i = 0; i < 8; i++)
+    {
+        key <<= 8;
+        if (i < s.size())
+        {
+            key |= (unsigned char)s[i];
+        }
+    }
+    return key;
+}
+
+//
+// Rearranges v so that the new v[i] is the old v[order[i]], where order is a
+// permutation of 0, 1, ..., v.size() - 1. order is changed.
+//
+// Each element is moved once by following cycles: the element that belongs
+// at position i is at order[i], the one that belongs there is at
+// order[order[i]], and so on back to i. Position j is marked as done by
+// setting order[j] = j.
+//
+template <typename T>
+void apply_permutation(vector<T> &v, vector<int> &order)
+{
+    for (int i = 0; i < v.size(); i++)
+    {
+        if (order[i] == i)
+        {
+            continue;
+        }
+        T first = std::move(v[i]);
+        int j = i;
+        while (order[j] != i)
+        {
+            int next = order[j];
+            v[j] = std::move(v[next]);
+            order[j] = j;
+            j = next;
+        }
+        v[j] = std::move(first);
+        order[j] = j;
+    }
+}
+
+void indirect_sort(vector<string> &v)
+{
+    struct Key
+    {
+        uint64_t prefix;
+        int length; // the string's length, or 9 if it's longer than 8
+        int index;
+    };
+
+    vector<Key> keys(v.size());
+    for (int i = 0; i < v.size(); i++)
+    {
+        keys[i] = {prefix_key(v[i]), int(min(v[i].size(), size_t(9))), i};
+    }
+
+    // If two prefixes are equal and one string has 8 or fewer characters,
+    // it's the other string's first characters followed by 0 bytes, so the
+    // shorter one is smaller (or they're the same if their lengths are). Equal
+    // strings are ordered by index, so the sort is stable.
+    std::sort(keys.begin(), keys.end(), [&v](const Key &a, const Key &b)
+              {
+                  if (a.prefix != b.prefix)
+                      return a.prefix < b.prefix;
+                  if (a.length != b.length)
+                      return a.length < b.length;
+                  if (a.length == 9)
+                  {
+                      int cmp = v[a.index].compare(8, string::npos, v[b.index], 8, string::npos);
+                      if (cmp != 0)
+                          return cmp < 0;
+                  }
+                  return a.index < b.index; });
+
+    vector<int> order(v.size());
+    for (int i = 0; i < v.size(); i++)
+    {
+        order[i] = keys[i].index;
+    }
+    apply_permutation(v, order);
+}
+
+class Indirect_sort_tester : public Sort_tester
+{
+    string sort_name() const
+    {
+        return "indirect sort";
+    }
+
+    void sort(vector<string> &v)
+    {
+        indirect_sort(v);
+    }
+};
+
+//
+// Returns size random strings of length len made of lowercase letters.
+//
+vector<string> make_rand_long_strings(int size, int len)
+{
+    vector<string> v(size);
+    for (string &s : v)
+    {
+        for (int i = 0; i < len; i++)
+        {
+            s += char('a' + rand() % 26);
+        }
+    }
+    return v;
+}
+
+//
+// Times std::sort and indirect_sort on long strings: random ones, and ones
+// that all start with the same 12 characters (the bad case for indirect_sort).
+//
+void time_long_string_sorts(int size, int len)
+{
+    vector<string> random_strings = make_rand_long_strings(size, len);
+    vector<string> same_prefix = random_strings;
+    for (string &s : same_prefix)
+    {
+        s = "https://www." + s;
+    }
+
+    for (const vector<string> *data : {&random_strings, &same_prefix})
+    {
+        string what = to_string(size) + " strings of length " + to_string((*data)[0].size());
+        if (data == &same_prefix)
+        {
+            what += " with the same first 12 characters";
+        }
+
+        cout << "std::sort on " << what << endl;
+        print_timing(time_runs(*data, [](vector<string> &v)
+                               { std::sort(v.begin(), v.end()); },
+                               5));
+        cout << "indirect sort on " << what << endl;
+        print_timing(time_runs(*data, [](vector<string> &v)
+                               { indirect_sort(v); },
+                               5));
+    }
+}
+
+
 int main()
 {
     //
@@ -548,12 +1751,27 @@ int main()
     // test_permutation_sort();
     // test_randomized_permutation_sort();
 
+    // block partitioning vs. the other quick sorts on ints; compile with -O3,
+    // and note that 100000000 ints takes 400MB of memory
+    // time_int_sorts(100000000);
+
+    // indirect sort vs. std::sort on long strings
+    // time_long_string_sorts(1000000, 64);
+
     Merge_sort_tester().time_sort(TIMING_WORDS);
+    Merge_sort_parallel_tester(1).time_sort(TIMING_WORDS);
+    Merge_sort_parallel_tester().time_sort(TIMING_WORDS);
     Quick_sort_tester().time_sort(TIMING_WORDS);
     Quick_sort_randomized_tester().time_sort(TIMING_WORDS);
+    Quick_sort_intro_tester().time_sort(TIMING_WORDS);
+    Quick_sort_block_tester().time_sort(TIMING_WORDS);
     Quick_sort2_tester().time_sort(TIMING_WORDS);
+    Sample_sort_tester(1).time_sort(TIMING_WORDS);
+    Sample_sort_tester().time_sort(TIMING_WORDS);
     Std_sort_tester().time_sort(TIMING_WORDS);
-    Bubble_sort_tester().time_sort(TIMING_WORDS);
+    Indirect_sort_tester().time_sort(TIMING_WORDS);
+    // bubble sort takes minutes, so only time it once
+    Bubble_sort_tester().time_sort(TIMING_WORDS, 1);
 
 } // main
 
@@ -586,3 +1804,24 @@ bubble_sort on 202651 words from tiny_shakespeare.txt
    254.879 seconds
 
 */
+
+/* time_int_sorts(100000000) on one core (-O3 optimizations):
+
+n            quick sort   quick sort intro   quick sort block   std::sort
+100000       0.0115       0.0122             0.0051             0.0086
+1000000      0.128        0.141              0.054              0.102
+10000000     1.48         1.62               0.648              1.19
+100000000    16.5         19.3               7.78               14.8
+
+(seconds of CPU time on random ints in [0, 1000000000])
+
+*/
+
+/* indirect sort vs. std::sort on one core (-O3 optimizations), median of 5:
+
+                                                     std::sort  indirect sort
+202651 words from tiny_shakespeare.txt               0.071      0.047
+1000000 random strings of length 64                  0.58       0.19
+1000000 strings of length 76, same first 12 chars    0.55       1.47
+
+*/